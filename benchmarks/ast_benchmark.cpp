@@ -0,0 +1,143 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+// Counts heap allocations and times parse and teardown of a generated feature,
+// with every node and container allocated individually from the heap
+// (new_delete_resource, the layout before the arena) and with the default
+// per-feature monotonic arena.
+//
+// Usage: PepinoAstBenchmark [size in MB, default 8]
+
+#include "../src/parsing/Lexer.h"
+#include "../src/parsing/Parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <string>
+
+namespace
+{
+std::atomic<size_t> g_allocations{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// std::pmr::new_delete_resource allocates through the aligned overloads.
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto alignment = std::max(static_cast<std::size_t>(align), sizeof(void*));
+    const auto rounded = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+    if (void* p = std::aligned_alloc(alignment, rounded))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+std::string generateFeature(size_t bytes)
+{
+    std::string source = "@generated\nFeature: Generated feature\n\n  Background:\n    Given a clean database\n\n";
+    for (size_t i = 0; source.size() < bytes; ++i)
+    {
+        const auto n = std::to_string(i);
+        source += "  Scenario: Generated scenario number " + n + "\n";
+        source += "    Given the user is on the login page\n";
+        source += "    When the user enters user_" + n + " and secret_" + n + "\n";
+        source += "    Then they should see the welcome message\n\n";
+        source += "  Scenario Outline: Generated outline number " + n + "\n";
+        source += "    When the user enters <username> and <password>\n";
+        source += "    Then they should see <message>\n\n";
+        source += "    Examples:\n";
+        source += "      | username | password | message |\n";
+        for (int row = 0; row < 4; ++row)
+        {
+            const auto r = std::to_string(row);
+            source += "      | user_" + r + " | secret_" + n + " | welcome_" + r + " |\n";
+        }
+        source += "\n";
+    }
+    return source;
+}
+
+void measure(const char* label, const std::string& source, std::pmr::memory_resource* resource)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const size_t before = g_allocations.load();
+    const auto start = Clock::now();
+    pep::Lexer lexer(source);
+    pep::Parser parser(lexer, resource);
+    auto feature = parser.parseFeature();
+    const auto parsed = Clock::now();
+    const size_t parseAllocations = g_allocations.load() - before;
+
+    const size_t scenarios = feature->scenarios.size() + feature->scenarioOutlines.size();
+    feature.reset();
+    const auto released = Clock::now();
+
+    const std::chrono::duration<double, std::milli> parseTime = parsed - start;
+    const std::chrono::duration<double, std::milli> teardownTime = released - parsed;
+    std::cout << std::setw(6) << label << ": " << parseAllocations << " allocations for " << scenarios
+              << " scenarios, parse " << std::fixed << std::setprecision(2) << parseTime.count() << " ms, teardown "
+              << teardownTime.count() << " ms" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    const std::string source = generateFeature(megabytes * 1024 * 1024);
+    std::cout << "Input: " << source.size() / 1024 << " KB" << std::endl;
+
+    measure("heap", source, std::pmr::new_delete_resource());
+    measure("arena", source, nullptr);
+    return 0;
+}
@@ -0,0 +1,115 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+// Measures lexing throughput (MB/s) for every scanner instruction set the CPU
+// supports, on a generated outline-heavy feature file. "scan" walks the words
+// the way the lexer does without storing tokens; "tokenize" is the full
+// Lexer::tokenize including building the token vector.
+//
+// Usage: PepinoLexerBenchmark [size in MB, default 32]
+
+#include "../src/parsing/Lexer.h"
+#include "../src/parsing/Scanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+std::string generateFeature(size_t bytes)
+{
+    std::string source = "@generated\nFeature: Generated feature\n\n";
+    for (size_t i = 0; source.size() < bytes; ++i)
+    {
+        const auto n = std::to_string(i);
+        source += "  @outline @case_" + n + "\n";
+        source += "  Scenario Outline: Generated outline number " + n + "\n";
+        source += "    Given the user is on the login page\n";
+        source += "    When the user enters <username> and <password>\n";
+        source += "    Then they should see the message <message>\n\n";
+        source += "    Examples:\n";
+        source += "      | username | password | message |\n";
+        for (int row = 0; row < 8; ++row)
+        {
+            const auto r = std::to_string(row);
+            source += "      | user_" + r + " | secret_" + n + " | welcome back user number " + r + " |\n";
+        }
+        source += "\n";
+    }
+    return source;
+}
+
+template <typename Fn> double bestOf(int runs, Fn&& fn)
+{
+    double best = 1e30;
+    for (int run = 0; run < runs; ++run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    const std::string source = generateFeature(megabytes * 1024 * 1024);
+    const double sizeMb = static_cast<double>(source.size()) / (1024.0 * 1024.0);
+    std::cout << "Input: " << std::fixed << std::setprecision(1) << sizeMb << " MB" << std::endl;
+
+    for (auto isa : { pep::scan::Isa::Scalar, pep::scan::Isa::Sse2, pep::scan::Isa::Avx2 })
+    {
+        if (!pep::scan::setIsa(isa))
+        {
+            std::cout << std::setw(8) << pep::scan::isaName(isa) << ": unsupported" << std::endl;
+            continue;
+        }
+        size_t wordCount = 0;
+        const double scan = bestOf(
+            5,
+            [&]
+            {
+                pep::scan::Scanner scanner(source);
+                wordCount = 0;
+                for (size_t pos = scanner.skipBlanks(0); pos < source.size(); pos = scanner.skipBlanks(pos))
+                {
+                    pos = source[pos] == '\n' ? pos + 1 : scanner.findWordEnd(pos + 1);
+                    ++wordCount;
+                }
+            });
+        size_t tokenCount = 0;
+        const double tokenize = bestOf(
+            5,
+            [&]
+            {
+                pep::Lexer lexer(source);
+                tokenCount = lexer.tokenize().size();
+            });
+        std::cout << std::setw(8) << pep::scan::isaName(isa) << ": scan " << std::setprecision(1) << sizeMb / scan
+                  << " MB/s (" << wordCount << " words), tokenize " << sizeMb / tokenize << " MB/s (" << tokenCount
+                  << " tokens)" << std::endl;
+    }
+    return 0;
+}
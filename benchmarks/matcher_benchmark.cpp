@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+// Times resolving step texts against growing numbers of step definitions
+// with each MatchStrategy. The resolution cache is cleared before every
+// lookup, so each one pays for a full match. Definitions come in three
+// shapes: plain literals, a literal prefix followed by a capture, and a
+// leading capture.
+//
+// Usage: PepinoMatcherBenchmark [definitions ...], default 100 1000 10000
+
+#include "pepino/context.h"
+#include "pepino/steps/StepRegistry.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+class BenchContext : public pep::Context<BenchContext>
+{
+public:
+    size_t calls = 0;
+};
+
+std::string literalStep(size_t i)
+{
+    return "the user " + std::to_string(i) + " opens the page";
+}
+
+void registerDefinitions(size_t from, size_t to)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    for (size_t i = from; i < to; ++i)
+    {
+        const auto n = std::to_string(i);
+        switch (i % 3)
+        {
+        case 0:
+        {
+            std::string pattern = "^";
+            pattern.append(literalStep(i)).append("$");
+            registry.registerStep<BenchContext>(
+                pep::types::StepType::Given, pattern, [](BenchContext& ctx) { ++ctx.calls; });
+            break;
+        }
+        case 1:
+            registry.registerStep<BenchContext>(pep::types::StepType::When,
+                                                "^order " + n + " has (\\d+) items$",
+                                                [](BenchContext& ctx, int) { ++ctx.calls; });
+            break;
+        default:
+            registry.registerStep<BenchContext>(pep::types::StepType::Then,
+                                                "^(\\w+) sends message " + n + "$",
+                                                [](BenchContext& ctx, std::string) { ++ctx.calls; });
+            break;
+        }
+    }
+}
+
+std::string stepText(size_t definition, size_t lookup)
+{
+    switch (definition % 3)
+    {
+    case 0:
+        return literalStep(definition);
+    case 1:
+        return "order " + std::to_string(definition) + " has " + std::to_string(lookup) + " items";
+    default:
+        return "user" + std::to_string(lookup) + " sends message " + std::to_string(definition);
+    }
+}
+
+double timeLookups(const std::vector<std::string>& texts)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& text : texts)
+    {
+        registry.clearResolutionCache();
+        registry.executeStep(text);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(texts.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = { 100, 1000, 10000 };
+
+    // executeStep logs every step it runs; keep that out of the timings.
+    auto* out = std::cout.rdbuf();
+    size_t registered = 0;
+    for (size_t definitions : sizes)
+    {
+        registerDefinitions(registered, definitions);
+        registered = std::max(registered, definitions);
+
+        std::vector<std::string> texts;
+        const size_t lookups = 300;
+        for (size_t i = 0; i < lookups; ++i)
+            texts.push_back(stepText((i * 7919) % registered, i));
+
+        std::cout << std::setw(6) << registered << " definitions:";
+        for (auto [strategy, name] : { std::pair{ pep::types::MatchStrategy::Linear, "linear" },
+                                       std::pair{ pep::types::MatchStrategy::Tiered, "tiered" },
+                                       std::pair{ pep::types::MatchStrategy::Automaton, "automaton" } })
+        {
+            pep::StepRegistry::getInstance().setMatchStrategy(strategy);
+            std::cout.rdbuf(nullptr);
+            timeLookups(texts); // Warm up; the automaton builds its states here
+            const double seconds = timeLookups(texts);
+            std::cout.clear();
+            std::cout.rdbuf(out);
+            std::cout << " " << name << " " << std::fixed << std::setprecision(2) << seconds * 1e6 << " us";
+        }
+        std::cout << std::endl;
+    }
+    return BenchContext::getInstance().calls == 0 ? 1 : 0;
+}
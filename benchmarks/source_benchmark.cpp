@@ -0,0 +1,120 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+// Compares loading a feature file through std::istreambuf_iterator into a
+// std::string (the previous TestController path) with SourceFile::open. Both
+// timings include touching every page of the result, so the lazily faulted-in
+// mapping is not measured as free. Files are read from a warm page cache.
+//
+// Usage: PepinoSourceBenchmark [size in MB ...], default 1 100 1024
+
+#include "../src/parsing/SourceFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+void writeFeature(const std::string& path, size_t bytes)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << "Feature: Generated feature\n\n";
+    size_t written = 0;
+    for (size_t i = 0; written < bytes; ++i)
+    {
+        const auto n = std::to_string(i);
+        std::string block = "  Scenario: Generated scenario number " + n + "\n";
+        block += "    Given the user is on the login page\n";
+        block += "    When the user enters user_" + n + " and secret_" + n + "\n";
+        block += "    Then they should see the welcome message\n\n";
+        out << block;
+        written += block.size();
+    }
+}
+
+// Reads one byte per page so every page is actually loaded.
+size_t touchPages(std::string_view text)
+{
+    size_t sum = 0;
+    for (size_t i = 0; i < text.size(); i += 4096)
+        sum += static_cast<unsigned char>(text[i]);
+    return sum;
+}
+
+template <typename Fn> double bestOf(int runs, Fn&& fn)
+{
+    double best = 1e30;
+    for (int run = 0; run < runs; ++run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = { 1, 100, 1024 };
+
+    const auto path = (std::filesystem::temp_directory_path() / "pepino_source_benchmark.feature").string();
+    size_t checksum = 0;
+    for (size_t megabytes : sizes)
+    {
+        writeFeature(path, megabytes * 1024 * 1024);
+        const int runs = megabytes >= 512 ? 3 : 5;
+
+        const double stream = bestOf(
+            runs,
+            [&]
+            {
+                std::ifstream file(path);
+                const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                checksum += touchPages(content);
+            });
+        bool mapped = false;
+        const double mmap = bestOf(
+            runs,
+            [&]
+            {
+                auto source = pep::SourceFile::open(path);
+                mapped = source->isMapped();
+                checksum += touchPages(source->view());
+            });
+
+        std::cout << std::setw(6) << megabytes << " MB: istreambuf " << std::fixed << std::setprecision(2)
+                  << stream * 1000.0 << " ms, SourceFile (" << (mapped ? "mmap" : "read") << ") " << mmap * 1000.0
+                  << " ms, " << std::setprecision(1) << stream / mmap << "x" << std::endl;
+    }
+    std::remove(path.c_str());
+    return checksum == 0 ? 1 : 0;
+}
@@ -16,20 +16,148 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace pep
 {
 
+/// A context that can be recycled: reset() must bring it back to the state
+/// of a freshly constructed one, keeping whatever is expensive to rebuild.
+template <typename T>
+concept ResettableContext = requires(T& context) { context.reset(); };
+
+/// Instances of a resettable context type that finished their scenario,
+/// reset and ready for the next one.
+template <typename Derived> class ContextPool
+{
+public:
+    static std::unique_ptr<Derived> acquire()
+    {
+        {
+            std::lock_guard lock(s_mutex);
+            if (!s_free.empty())
+            {
+                auto context = std::move(s_free.back());
+                s_free.pop_back();
+                return context;
+            }
+        }
+        return std::make_unique<Derived>();
+    }
+
+    static void release(std::unique_ptr<Derived> context)
+    {
+        try
+        {
+            context->reset();
+        }
+        catch (...)
+        {
+            return; // Not reusable; dropped
+        }
+        std::lock_guard lock(s_mutex);
+        s_free.push_back(std::move(context));
+    }
+
+    /// Number of instances waiting for reuse.
+    static size_t size()
+    {
+        std::lock_guard lock(s_mutex);
+        return s_free.size();
+    }
+
+private:
+    static inline std::mutex s_mutex;
+    static inline std::vector<std::unique_ptr<Derived>> s_free;
+};
+
+/// The contexts of one running scenario, each created on first use and
+/// destroyed with the scenario. While a ScenarioContexts is active on a
+/// thread, Context<Derived>::getInstance() on that thread returns the
+/// scenario's Derived instead of the process-wide one. With `pooled`,
+/// resettable contexts come from and go back to their ContextPool.
+class ScenarioContexts
+{
+public:
+    explicit ScenarioContexts(bool pooled = false) : m_pooled(pooled) {}
+    ScenarioContexts(const ScenarioContexts&) = delete;
+    ScenarioContexts& operator=(const ScenarioContexts&) = delete;
+
+    ~ScenarioContexts()
+    {
+        // Contexts created later may refer to earlier ones.
+        while (!m_instances.empty())
+            m_instances.pop_back();
+    }
+
+    template <typename Derived> Derived& get()
+    {
+        for (auto& [key, instance] : m_instances)
+        {
+            if (key == &typeKey<Derived>)
+                return *static_cast<Derived*>(instance.get());
+        }
+        Instance instance(nullptr, nullptr);
+        if constexpr (ResettableContext<Derived>)
+        {
+            if (m_pooled)
+            {
+                instance = Instance(ContextPool<Derived>::acquire().release(),
+                                    [](void* context)
+                                    { ContextPool<Derived>::release(std::unique_ptr<Derived>(static_cast<Derived*>(context))); });
+            }
+        }
+        if (!instance)
+        {
+            instance = Instance(new Derived(), [](void* context) { delete static_cast<Derived*>(context); });
+        }
+        auto& entry = m_instances.emplace_back(&typeKey<Derived>, std::move(instance));
+        return *static_cast<Derived*>(entry.second.get());
+    }
+
+    /// The contexts active on this thread, or null outside a scenario.
+    static ScenarioContexts* current() { return s_current; }
+
+    /// Makes `contexts` the active ones on this thread for its lifetime.
+    class Activation
+    {
+    public:
+        explicit Activation(ScenarioContexts& contexts) : m_previous(std::exchange(s_current, &contexts)) {}
+        ~Activation() { s_current = m_previous; }
+        Activation(const Activation&) = delete;
+        Activation& operator=(const Activation&) = delete;
+
+    private:
+        ScenarioContexts* m_previous;
+    };
+
+private:
+    using Instance = std::unique_ptr<void, void (*)(void*)>;
+    template <typename T> static constexpr char typeKey = 0;
+
+    bool m_pooled;
+    std::vector<std::pair<const char*, Instance>> m_instances; // Few types per scenario, so a vector
+    static inline thread_local ScenarioContexts* s_current = nullptr;
+};
+
 template <typename Derived> class Context
 {
 public:
-    /// Returns the one and only instance of Derived.
+    /// Returns the instance of Derived for the scenario running on this
+    /// thread, or the process-wide one outside a scenario.
     static Derived& getInstance()
     {
+        if (ScenarioContexts* scenario = ScenarioContexts::current())
+            return scenario->get<Derived>();
         static Derived instance;
         return instance;
     }
 
-    // Disable copy & move — there is only one instance!
+    // Disable copy & move — one instance per scenario!
     Context(const Context&) = delete;
     Context& operator=(const Context&) = delete;
     Context(Context&&) = delete;
@@ -15,13 +15,74 @@
  *******************************************************************************/
 #pragma once
 
+#include "pepino/types/types.h"
+
+#include <cstddef>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace pep
 {
 
+// Options for a run. The defaults are what the single-argument overloads use.
+struct RunOptions
+{
+    // Directory for cached parse results; empty disables caching. Unchanged
+    // feature files are then loaded from the cache instead of being parsed.
+    std::string cacheDirectory;
+    // Threads used to read and parse feature files; 0 uses one per core.
+    unsigned jobs = 0;
+    // How step texts are matched against the registered step definitions.
+    types::MatchStrategy matchStrategy = types::MatchStrategy::Tiered;
+    // The regex engine step patterns are compiled with.
+    types::RegexBackend regexBackend = types::RegexBackend::Builtin;
+    // Match Given steps only against GIVEN definitions (and AND/BUT ones),
+    // likewise for When and Then. And/But steps take the keyword before them.
+    bool strictKeywords = false;
+    // Scenarios (and outline rows) run at once. 1 runs them in order on the
+    // calling thread, stopping at the first failure; otherwise they run on a
+    // pool of this many threads (0: one per core), each with contexts of its
+    // own, and every scenario runs. Hooks must then be thread-safe.
+    unsigned scenarioThreads = 1;
+    // Run scenarios in this many worker processes instead, forked once per
+    // run, so a step that crashes fails its scenario rather than the run.
+    // Overrides scenarioThreads; 0 keeps everything in this process.
+    unsigned scenarioProcesses = 0;
+    // Limits for each worker process; 0 means none. Memory is the address
+    // space in bytes, CPU the seconds each scenario may use. A scenario over
+    // the CPU limit is killed with SIGXCPU and reported as crashed.
+    size_t workerMemoryLimit = 0;
+    unsigned workerCpuSeconds = 0;
+    // How long the contexts steps receive live. Per scenario by default, so no
+    // state leaks from one scenario into the next; Pooled additionally
+    // recycles contexts that define reset() instead of rebuilding them.
+    types::ContextLifetime contextLifetime = types::ContextLifetime::Scenario;
+    // Run only shard `shardIndex` of `shardCount`. Every shard expands the
+    // same features into the same scenarios and keeps its own part, chosen
+    // from the scenario ids alone, so any machine can run any shard.
+    unsigned shardIndex = 0;
+    unsigned shardCount = 1;
+    // A result file of an earlier run. Its scenario durations are used to
+    // give every shard about the same amount of work; scenarios it does not
+    // know count as average ones.
+    std::string shardDurations{};
+    // Where to write this run's results; empty writes none. The result files
+    // of all shards can be combined with PepinoMergeResults.
+    std::string resultFile{};
+};
+
+// Runs with shared contexts, so a test can inspect them afterwards.
 int debug_runStep(const std::string& pattern);
-int run(const std::string& filepath);
+
+// `path` is a feature file, a directory (searched recursively for .feature
+// files) or a glob pattern such as "features/*.feature". Several files are
+// parsed in parallel and run in sorted order; a parse error in any of them is
+// reported together with all the others before anything runs.
+int run(const std::string& path);
+int run(const std::string& path, const RunOptions& options);
+// Runs the given feature files in order.
+int run(const std::vector<std::string>& paths);
+int run(const std::vector<std::string>& paths, const RunOptions& options);
 
 } // namespace pep
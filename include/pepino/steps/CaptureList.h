@@ -0,0 +1,62 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace pep
+{
+
+// The captures of a matched step, as views into the step text. Up to
+// InlineCapacity of them are stored in place, so the common step needs no
+// heap allocation to pass its arguments on.
+class CaptureList
+{
+public:
+    static constexpr size_t InlineCapacity = 8;
+
+    void push_back(std::string_view capture)
+    {
+        if (m_size < InlineCapacity)
+        {
+            m_inline[m_size] = capture;
+        }
+        else
+        {
+            if (m_size == InlineCapacity)
+                m_overflow.assign(m_inline.begin(), m_inline.end());
+            m_overflow.push_back(capture);
+        }
+        ++m_size;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const std::string_view* begin() const { return m_size <= InlineCapacity ? m_inline.data() : m_overflow.data(); }
+    const std::string_view* end() const { return begin() + m_size; }
+    std::string_view operator[](size_t i) const { return begin()[i]; }
+
+private:
+    std::array<std::string_view, InlineCapacity> m_inline;
+    std::vector<std::string_view> m_overflow; // Every capture, once there are more than InlineCapacity
+    size_t m_size = 0;
+};
+
+} // namespace pep
@@ -0,0 +1,648 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pep::matching
+{
+
+// A set of bytes. Patterns are matched byte by byte, like std::regex over
+// char, so UTF-8 text needs no special handling.
+struct ByteSet
+{
+    std::array<uint64_t, 4> bits{};
+
+    constexpr bool test(uint8_t c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+    constexpr void set(uint8_t c) { bits[c >> 6] |= uint64_t(1) << (c & 63); }
+    constexpr void setRange(uint8_t first, uint8_t last)
+    {
+        for (unsigned c = first; c <= last; ++c)
+            set(static_cast<uint8_t>(c));
+    }
+    constexpr void merge(const ByteSet& other)
+    {
+        for (size_t i = 0; i < bits.size(); ++i)
+            bits[i] |= other.bits[i];
+    }
+    constexpr void invert()
+    {
+        for (auto& word : bits)
+            word = ~word;
+    }
+};
+
+// One instruction of a Thompson NFA.
+struct Inst
+{
+    enum class Op : uint8_t
+    {
+        Set,         // Consume a byte in sets[x], continue at pc + 1
+        Split,       // Continue at x and at y, preferring x
+        Jump,        // Continue at x
+        Save,        // Record the position in capture slot x
+        AssertBegin, // Only at the start of the text
+        AssertEnd,   // Only at the end of the text
+        Match        // Pattern x matched
+    };
+
+    Op op;
+    uint32_t x = 0;
+    uint32_t y = 0;
+};
+
+// Any number of compiled patterns sharing one instruction list.
+struct Program
+{
+    std::vector<Inst> insts;
+    std::vector<ByteSet> sets;
+};
+
+struct CompiledPattern
+{
+    uint32_t start;  // First instruction of the pattern
+    uint32_t groups; // Capturing groups, not counting the whole match
+};
+
+// [offset, length) of each capturing group within the matched text.
+using CaptureSpans = std::vector<std::pair<uint32_t, uint32_t>>;
+
+// A compiled pattern wherever its instructions live: in a Program, or in
+// arrays built at compile time by the CT_* step macros.
+struct ProgramView
+{
+    const Inst* insts;
+    size_t size;
+    const ByteSet* sets;
+    uint32_t groups;
+};
+
+// Whether the program starting at insts[0] matches all of `text`, filling
+// `captures` (if given) on a match. Linear in text length x program size.
+bool matchProgram(const ProgramView& program, std::string_view text, CaptureSpans* captures);
+
+namespace detail
+{
+constexpr bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool isAlnum(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr uint32_t Unbounded = std::numeric_limits<uint32_t>::max();
+// Counted repetitions are expanded; a pattern growing past this is left to
+// std::regex.
+constexpr size_t MaxInstructions = 1 << 14;
+
+struct Node
+{
+    enum class Kind
+    {
+        Empty,
+        Set,
+        Concat,
+        Alternate,
+        Repeat,
+        Group,
+        Begin,
+        End
+    };
+
+    Kind kind = Kind::Empty;
+    ByteSet set{};
+    std::vector<Node> children{};
+    uint32_t min = 0;
+    uint32_t max = 0;
+    bool greedy = true;
+    uint32_t group = 0; // Capture index of a Group, 0 if it does not capture
+};
+
+constexpr ByteSet digitSet()
+{
+    ByteSet set;
+    set.setRange('0', '9');
+    return set;
+}
+
+constexpr ByteSet wordSet()
+{
+    ByteSet set;
+    set.setRange('a', 'z');
+    set.setRange('A', 'Z');
+    set.setRange('0', '9');
+    set.set('_');
+    return set;
+}
+
+constexpr ByteSet spaceSet()
+{
+    ByteSet set;
+    for (char c : std::string_view(" \t\n\v\f\r"))
+        set.set(static_cast<uint8_t>(c));
+    return set;
+}
+
+constexpr ByteSet singleByte(uint8_t c)
+{
+    ByteSet set;
+    set.set(c);
+    return set;
+}
+
+// Recursive-descent parser for the supported subset. Any construct outside of
+// it clears `ok` instead of guessing at what std::regex would do.
+class PatternParser
+{
+public:
+    constexpr explicit PatternParser(std::string_view pattern) : m_pattern(pattern) {}
+
+    constexpr bool parse(Node& root)
+    {
+        root = parseAlternation();
+        return m_ok && m_pos == m_pattern.size();
+    }
+
+    constexpr uint32_t groups() const { return m_groups; }
+
+private:
+    constexpr bool atEnd() const { return m_pos >= m_pattern.size(); }
+    constexpr char peek() const { return m_pattern[m_pos]; }
+
+    constexpr Node fail()
+    {
+        m_ok = false;
+        m_pos = m_pattern.size();
+        return {};
+    }
+
+    constexpr Node parseAlternation()
+    {
+        Node first = parseConcat();
+        if (atEnd() || peek() != '|')
+            return first;
+        Node alternate{ Node::Kind::Alternate };
+        alternate.children.push_back(std::move(first));
+        while (m_ok && !atEnd() && peek() == '|')
+        {
+            ++m_pos;
+            alternate.children.push_back(parseConcat());
+        }
+        return alternate;
+    }
+
+    constexpr Node parseConcat()
+    {
+        Node concat{ Node::Kind::Concat };
+        while (m_ok && !atEnd() && peek() != '|' && peek() != ')')
+            concat.children.push_back(parseRepeat());
+        return concat;
+    }
+
+    constexpr Node parseRepeat()
+    {
+        Node atom = parseAtom();
+        if (!m_ok || atEnd())
+            return atom;
+
+        uint32_t min = 0;
+        uint32_t max = 0;
+        switch (peek())
+        {
+        case '*':
+            max = Unbounded;
+            ++m_pos;
+            break;
+        case '+':
+            min = 1;
+            max = Unbounded;
+            ++m_pos;
+            break;
+        case '?':
+            max = 1;
+            ++m_pos;
+            break;
+        case '{':
+            if (!parseBraces(min, max))
+                return fail();
+            break;
+        default:
+            return atom;
+        }
+        if (atom.kind == Node::Kind::Begin || atom.kind == Node::Kind::End)
+            return fail();
+
+        Node repeat{ Node::Kind::Repeat };
+        repeat.min = min;
+        repeat.max = max;
+        if (!atEnd() && peek() == '?')
+        {
+            repeat.greedy = false;
+            ++m_pos;
+        }
+        if (!atEnd() && (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{'))
+            return fail();
+        repeat.children.push_back(std::move(atom));
+        return repeat;
+    }
+
+    // {n}, {n,} or {n,m}
+    constexpr bool parseBraces(uint32_t& min, uint32_t& max)
+    {
+        ++m_pos;
+        if (!parseNumber(min))
+            return false;
+        max = min;
+        if (!atEnd() && peek() == ',')
+        {
+            ++m_pos;
+            max = Unbounded;
+            if (!atEnd() && peek() != '}' && !parseNumber(max))
+                return false;
+        }
+        if (atEnd() || peek() != '}' || max < min)
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    constexpr bool parseNumber(uint32_t& value)
+    {
+        const size_t start = m_pos;
+        value = 0;
+        while (!atEnd() && isDigit(peek()) && m_pos - start < 4)
+            value = value * 10 + static_cast<uint32_t>(m_pattern[m_pos++] - '0');
+        return m_pos > start && (atEnd() || !isDigit(peek()));
+    }
+
+    constexpr Node parseAtom()
+    {
+        const char c = peek();
+        switch (c)
+        {
+        case '(':
+            return parseGroup();
+        case '[':
+            return parseClass();
+        case '.':
+        {
+            ++m_pos;
+            Node any{ Node::Kind::Set };
+            any.set.invert();
+            any.set.bits[0] &= ~((uint64_t(1) << '\n') | (uint64_t(1) << '\r'));
+            return any;
+        }
+        case '^':
+            ++m_pos;
+            return Node{ Node::Kind::Begin };
+        case '$':
+            ++m_pos;
+            return Node{ Node::Kind::End };
+        case '\\':
+        {
+            ++m_pos;
+            ByteSet set;
+            if (!parseEscape(set))
+                return fail();
+            Node node{ Node::Kind::Set };
+            node.set = set;
+            return node;
+        }
+        case ')':
+        case ']':
+        case '}':
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            return fail();
+        default:
+        {
+            ++m_pos;
+            Node node{ Node::Kind::Set };
+            node.set = singleByte(static_cast<uint8_t>(c));
+            return node;
+        }
+        }
+    }
+
+    constexpr Node parseGroup()
+    {
+        ++m_pos;
+        Node group{ Node::Kind::Group };
+        if (!atEnd() && peek() == '?')
+        {
+            // Only non-capturing groups; lookaheads are not supported.
+            if (m_pos + 1 >= m_pattern.size() || m_pattern[m_pos + 1] != ':')
+                return fail();
+            m_pos += 2;
+        }
+        else
+        {
+            group.group = ++m_groups;
+        }
+        group.children.push_back(parseAlternation());
+        if (!m_ok || atEnd() || peek() != ')')
+            return fail();
+        ++m_pos;
+        return group;
+    }
+
+    // The escape after a backslash. `single` is set when it stands for one
+    // byte (and so can bound a range in a class).
+    constexpr bool parseEscape(ByteSet& set, bool* single = nullptr)
+    {
+        if (atEnd())
+            return false;
+        const char c = m_pattern[m_pos++];
+        if (single)
+            *single = false;
+        switch (c)
+        {
+        case 'd':
+            set.merge(digitSet());
+            return true;
+        case 'w':
+            set.merge(wordSet());
+            return true;
+        case 's':
+            set.merge(spaceSet());
+            return true;
+        case 'D':
+        case 'W':
+        case 'S':
+        {
+            ByteSet inverse = c == 'D' ? digitSet() : c == 'W' ? wordSet() : spaceSet();
+            inverse.invert();
+            set.merge(inverse);
+            return true;
+        }
+        default:
+            break;
+        }
+        uint8_t byte;
+        switch (c)
+        {
+        case 't':
+            byte = '\t';
+            break;
+        case 'n':
+            byte = '\n';
+            break;
+        case 'r':
+            byte = '\r';
+            break;
+        case 'f':
+            byte = '\f';
+            break;
+        case 'v':
+            byte = '\v';
+            break;
+        default:
+            // \b, back-references, \x, \u, \c and friends are not supported.
+            if (isAlnum(c))
+                return false;
+            byte = static_cast<uint8_t>(c);
+            break;
+        }
+        set.set(byte);
+        if (single)
+            *single = true;
+        return true;
+    }
+
+    // One member of a class: a byte, or an escape. `last` is the byte when
+    // the member is a single one.
+    constexpr bool parseClassAtom(ByteSet& set, bool& single, uint8_t& last)
+    {
+        if (peek() == '\\')
+        {
+            ++m_pos;
+            ByteSet escaped;
+            if (!parseEscape(escaped, &single))
+                return false;
+            set.merge(escaped);
+            if (single)
+            {
+                for (unsigned b = 0; b < 256; ++b)
+                {
+                    if (escaped.test(static_cast<uint8_t>(b)))
+                        last = static_cast<uint8_t>(b);
+                }
+            }
+            return true;
+        }
+        last = static_cast<uint8_t>(m_pattern[m_pos++]);
+        set.set(last);
+        single = true;
+        return true;
+    }
+
+    constexpr Node parseClass()
+    {
+        ++m_pos;
+        bool negate = false;
+        if (!atEnd() && peek() == '^')
+        {
+            negate = true;
+            ++m_pos;
+        }
+        if (atEnd() || peek() == ']')
+            return fail();
+
+        ByteSet set;
+        while (!atEnd() && peek() != ']')
+        {
+            // A nested '[' may start a POSIX class such as [:alpha:].
+            if (peek() == '[')
+                return fail();
+            bool single = false;
+            uint8_t first = 0;
+            if (!parseClassAtom(set, single, first))
+                return fail();
+            if (m_pos + 1 < m_pattern.size() && peek() == '-' && m_pattern[m_pos + 1] != ']')
+            {
+                ++m_pos;
+                ByteSet ignored;
+                bool singleLast = false;
+                uint8_t last = 0;
+                if (!single || peek() == '[' || !parseClassAtom(ignored, singleLast, last) || !singleLast ||
+                    last < first)
+                    return fail();
+                set.setRange(first, last);
+            }
+        }
+        if (atEnd())
+            return fail();
+        ++m_pos;
+        if (negate)
+            set.invert();
+        Node node{ Node::Kind::Set };
+        node.set = set;
+        return node;
+    }
+
+    std::string_view m_pattern;
+    size_t m_pos = 0;
+    uint32_t m_groups = 0;
+    bool m_ok = true;
+};
+
+class Emitter
+{
+public:
+    constexpr explicit Emitter(Program& program) : m_program(program) {}
+
+    constexpr uint32_t pc() const { return static_cast<uint32_t>(m_program.insts.size()); }
+
+    constexpr uint32_t push(Inst::Op op, uint32_t x = 0, uint32_t y = 0)
+    {
+        m_program.insts.push_back({ op, x, y });
+        return pc() - 1;
+    }
+
+    constexpr bool overflowed(size_t start) const { return m_program.insts.size() - start > MaxInstructions; }
+
+    constexpr void emit(const Node& node, size_t start)
+    {
+        if (overflowed(start))
+            return;
+        switch (node.kind)
+        {
+        case Node::Kind::Empty:
+            break;
+        case Node::Kind::Set:
+            m_program.sets.push_back(node.set);
+            push(Inst::Op::Set, static_cast<uint32_t>(m_program.sets.size() - 1));
+            break;
+        case Node::Kind::Concat:
+            for (const auto& child : node.children)
+                emit(child, start);
+            break;
+        case Node::Kind::Alternate:
+        {
+            std::vector<uint32_t> exits;
+            for (size_t i = 0; i < node.children.size(); ++i)
+            {
+                if (i + 1 == node.children.size())
+                {
+                    emit(node.children[i], start);
+                    break;
+                }
+                const uint32_t split = push(Inst::Op::Split, pc() + 1);
+                emit(node.children[i], start);
+                exits.push_back(push(Inst::Op::Jump));
+                m_program.insts[split].y = pc();
+            }
+            for (uint32_t exit : exits)
+                m_program.insts[exit].x = pc();
+            break;
+        }
+        case Node::Kind::Group:
+            if (node.group)
+                push(Inst::Op::Save, 2 * node.group);
+            emit(node.children[0], start);
+            if (node.group)
+                push(Inst::Op::Save, 2 * node.group + 1);
+            break;
+        case Node::Kind::Begin:
+            push(Inst::Op::AssertBegin);
+            break;
+        case Node::Kind::End:
+            push(Inst::Op::AssertEnd);
+            break;
+        case Node::Kind::Repeat:
+            emitRepeat(node, start);
+            break;
+        }
+    }
+
+private:
+    // Splits prefer their x branch; a lazy quantifier prefers to stop.
+    constexpr void setBranches(uint32_t split, uint32_t body, uint32_t out, bool greedy)
+    {
+        m_program.insts[split].x = greedy ? body : out;
+        m_program.insts[split].y = greedy ? out : body;
+    }
+
+    constexpr void emitRepeat(const Node& node, size_t start)
+    {
+        const Node& child = node.children[0];
+        for (uint32_t i = 0; i < node.min && !overflowed(start); ++i)
+            emit(child, start);
+
+        if (node.max == Unbounded)
+        {
+            const uint32_t split = push(Inst::Op::Split);
+            emit(child, start);
+            push(Inst::Op::Jump, split);
+            setBranches(split, split + 1, pc(), node.greedy);
+            return;
+        }
+
+        std::vector<uint32_t> splits;
+        for (uint32_t i = node.min; i < node.max && !overflowed(start); ++i)
+        {
+            splits.push_back(push(Inst::Op::Split));
+            emit(child, start);
+        }
+        for (uint32_t split : splits)
+            setBranches(split, split + 1, pc(), node.greedy);
+    }
+
+    Program& m_program;
+};
+} // namespace detail
+
+// Appends `pattern` to `program`; reaching its Match instruction means the
+// pattern matched, and slots 2n and 2n + 1 receive the bounds of group n.
+// Covers the ECMAScript syntax step patterns use: literals and escapes,
+// classes, '.', groups, alternation, greedy and lazy quantifiers, '^' and '$'.
+// Returns nothing, leaving `program` unchanged, for anything else (e.g.
+// back-references, lookahead or \b); such patterns need std::regex.
+constexpr std::optional<CompiledPattern> compile(std::string_view pattern, uint32_t patternId, Program& program)
+{
+    detail::PatternParser parser(pattern);
+    detail::Node root;
+    if (!parser.parse(root))
+        return std::nullopt;
+
+    const size_t instCount = program.insts.size();
+    const size_t setCount = program.sets.size();
+    detail::Emitter emitter(program);
+    const uint32_t start = emitter.push(Inst::Op::Save, 0);
+    emitter.emit(root, instCount);
+    emitter.push(Inst::Op::Save, 1);
+    emitter.push(Inst::Op::Match, patternId);
+    if (emitter.overflowed(instCount))
+    {
+        program.insts.resize(instCount);
+        program.sets.resize(setCount);
+        return std::nullopt;
+    }
+    return CompiledPattern{ start, parser.groups() };
+}
+
+} // namespace pep::matching
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "RegexProgram.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace pep
+{
+
+// A string literal usable as a template argument.
+template <size_t N> struct FixedString
+{
+    char data[N]{};
+
+    constexpr FixedString(const char (&text)[N]) { std::copy_n(text, N, data); }
+    constexpr std::string_view view() const { return { data, N - 1 }; }
+};
+
+// A step pattern compiled while the program is being compiled: the NFA lives
+// in constant data, so registering the step builds no regex at startup, and
+// a pattern outside the supported syntax is a compile error.
+template <FixedString Pattern> class StaticPattern
+{
+    struct Sizes
+    {
+        bool ok;
+        size_t insts;
+        size_t sets;
+        uint32_t groups;
+    };
+
+    static constexpr Sizes sizes = []
+    {
+        matching::Program program;
+        const auto compiled = matching::compile(Pattern.view(), 0, program);
+        return Sizes{ compiled.has_value(), program.insts.size(), program.sets.size(), compiled ? compiled->groups : 0 };
+    }();
+    static_assert(sizes.ok, "Step pattern uses syntax the compile-time matcher does not support; use the runtime macros");
+
+    struct Data
+    {
+        std::array<matching::Inst, sizes.insts> insts;
+        std::array<matching::ByteSet, sizes.sets> sets;
+    };
+
+    static constexpr Data data = []
+    {
+        matching::Program program;
+        matching::compile(Pattern.view(), 0, program);
+        Data out{};
+        std::copy(program.insts.begin(), program.insts.end(), out.insts.begin());
+        std::copy(program.sets.begin(), program.sets.end(), out.sets.begin());
+        return out;
+    }();
+
+public:
+    static constexpr std::string_view text = Pattern.view();
+    static constexpr uint32_t groups = sizes.groups;
+    static constexpr matching::ProgramView program{ data.insts.data(), data.insts.size(), data.sets.data(), groups };
+};
+
+} // namespace pep
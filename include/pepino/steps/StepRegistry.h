@@ -15,16 +15,24 @@
  *******************************************************************************/
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <iostream>
-#include <regex>
+#include <memory>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "CaptureList.h"
+#include "StaticPattern.h"
 #include "TypeConverters.h"
 #include "pepino/context.h"
 #include "pepino/types/types.h"
@@ -32,6 +40,13 @@
 namespace pep
 {
 
+namespace matching
+{
+class Automaton;
+class IStepMatcher;
+class StepIndex;
+} // namespace matching
+
 template <typename T> struct function_traits;
 
 // Extract operator() signature for lambdas/functors
@@ -47,10 +62,14 @@ private:
     struct StepDefinition
     {
         types::StepType type;
-        std::regex pattern;
+        std::shared_ptr<const matching::IStepMatcher> matcher; // Compiled from patternStr on registration
+        const matching::ProgramView* program = nullptr;       // Set when compiled at build time
         std::string patternStr;
         int specificity;
-        std::function<void(const std::vector<std::string>&)> func;
+        std::function<void(const CaptureList&)> func;
+        // Converts the captures once and returns a call that runs the step
+        // with them; string_view arguments keep viewing the captured text.
+        std::function<std::function<void()>(const CaptureList&)> prepare;
     };
     using StepDefinitionPtr = std::shared_ptr<StepDefinition>;
 
@@ -63,67 +82,97 @@ public:
 
     /// Register a step whose callback takes (DerivedContext&, Args...).
     /// The wrapper will fetch DerivedContext::getInstance() internally.
+    /// `patternStr` is a regex, or a Cucumber Expression such as
+    /// "user {string} has {int} item(s)" when it names a parameter type and
+    /// is not anchored with ^ or $.
     template <typename DerivedContext, typename Callback>
     void registerStep(types::StepType type, const std::string& patternStr, Callback callback)
     {
-        std::regex pattern(patternStr);
-        int spec = computeSpecificity(patternStr);
+        addStep(makeDefinition<DerivedContext>(type, patternStr, std::move(callback)));
+    }
 
-        // Wrap user callback: grab the singleton and dispatch
-        auto wrapper = [callback](const std::vector<std::string>& args)
-        {
-            auto& ctx = DerivedContext::getInstance();
-            callWithArgs(callback, ctx, args);
-        };
+    /// Like registerStep, with the pattern compiled at build time. The number
+    /// of capture groups is checked against the callback's arguments then too.
+    template <typename DerivedContext, FixedString Pattern, typename Callback>
+    void registerStaticStep(types::StepType type, Callback callback)
+    {
+        using Functor = std::remove_reference_t<Callback>;
+        using Traits = function_traits<decltype(&Functor::operator())>;
+        static_assert(StaticPattern<Pattern>::groups + 1 == std::tuple_size_v<typename Traits::args_tuple>,
+                      "The step pattern must have one capture group per callback argument after the context");
 
-        auto stepDef = std::make_shared<StepDefinition>();
-        stepDef->type = type;
-        stepDef->pattern = std::move(pattern);
-        stepDef->patternStr = patternStr;
-        stepDef->specificity = spec;
-        stepDef->func = std::move(wrapper);
+        auto stepDef = makeDefinition<DerivedContext>(type, std::string(Pattern.view()), std::move(callback));
+        stepDef->program = &StaticPattern<Pattern>::program;
+        addStep(std::move(stepDef));
+    }
 
-        steps.push_back(std::move(stepDef));
+    /// Defines the Cucumber Expression parameter type {name}: a slot may hold
+    /// any text `accepts` returns true for, the longest such text preferred.
+    /// Must happen before a step using it runs; registering those steps
+    /// earlier is fine.
+    void defineParameterType(std::string name, std::function<bool(std::string_view)> accepts);
+
+    /// Defines {name} as the texts Converter<T> accepts, so a slot of this
+    /// type always converts to a T argument.
+    template <typename T> void defineParameterType(std::string name)
+    {
+        defineParameterType(std::move(name),
+                            [](std::string_view text)
+                            {
+                                T value{};
+                                return Converter<T>::parse(text, value);
+                            });
     }
 
     /// Match `stepText` against all registered patterns, pick the most
-    /// specific, extract captures, and invoke its wrapper.
-    void executeStep(const std::string& stepText) const
-    {
-        std::vector<StepDefinitionPtr> candidates;
-        for (const auto& sd : steps)
-        {
-            std::smatch m;
-            if (std::regex_match(stepText, m, sd->pattern))
-                candidates.push_back(sd);
-        }
-        if (candidates.empty())
-        {
-            throw std::runtime_error("No matching step found for: (START)" + stepText + "(END)");
-        }
+    /// specific, extract captures, and invoke its wrapper. The outcome is
+    /// cached per step text, so repeated steps skip regex matching.
+    void executeStep(std::string_view stepText) const;
+    /// Like executeStep(stepText), for a step with `keyword`: Given, When or
+    /// Then, with And and But already replaced by the keyword before them.
+    /// Only strict mode takes the keyword into account.
+    void executeStep(types::StepType keyword, std::string_view stepText) const;
 
-        // Choose highest specificity
-        auto best = candidates.front();
-        for (auto& cand : candidates)
-        {
-            if (cand->specificity > best->specificity)
-                best = cand;
-        }
+    /// A step text bound ahead of the run, as execution plans do.
+    struct BoundStep
+    {
+        std::string pattern;                    // Empty if no definition matches
+        std::vector<std::string> ambiguousWith; // Other matching patterns ranked as high
+        std::function<void()> call;             // Runs the step with its converted arguments
+    };
+    /// Resolves `stepText` and converts its arguments without running it.
+    /// `stepText` must outlive the returned call. Throws
+    /// StepArgumentException if a capture does not convert.
+    BoundStep bindStep(types::StepType keyword, std::string_view stepText) const;
 
-        std::cout << "Executing step with regex: " << best->patternStr << std::endl;
+    /// In strict mode a Given step only matches definitions registered with
+    /// GIVEN (or AND/BUT, which fit any keyword), and likewise for When and
+    /// Then. Off by default, where every definition matches every keyword.
+    /// Meant for startup only, like setMatchStrategy.
+    void setStrictKeywords(bool strict);
+    bool strictKeywords() const { return m_strict; }
 
-        std::smatch match;
-        if (!std::regex_match(stepText, match, best->pattern))
-        {
-            throw std::runtime_error("No matching step found for: (START)" + stepText + "(END)");
-        }
+    /// Selects how step texts are matched. Meant to be called once at
+    /// startup, before any step runs; it is not safe while steps execute.
+    void setMatchStrategy(types::MatchStrategy strategy);
+    types::MatchStrategy matchStrategy() const { return m_strategy; }
 
-        std::vector<std::string> captures;
-        for (size_t i = 1; i < match.size(); ++i)
-            captures.push_back(match[i].str());
+    /// Selects the regex engine and recompiles every registered pattern.
+    /// Like setMatchStrategy, meant for startup only.
+    void setRegexBackend(types::RegexBackend backend);
+    types::RegexBackend regexBackend() const { return m_backend; }
 
-        best->func(captures);
-    }
+    struct CacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t entries = 0;
+    };
+    /// Counters of the step resolution cache since the last clear.
+    CacheStats cacheStats() const;
+    /// Drops every cached resolution and resets the counters. Registering a
+    /// step does this automatically.
+    void clearResolutionCache();
 
     class UnimplementedStepException : public std::exception
     {
@@ -153,61 +202,91 @@ public:
     };
 
 private:
+    // What a step text resolved to: the winning definition (null if nothing
+    // matched) and the [offset, length) of each capture within the text.
+    struct Resolution
+    {
+        StepDefinitionPtr definition;
+        std::vector<std::pair<uint32_t, uint32_t>> captures;
+    };
+    using ResolutionPtr = std::shared_ptr<const Resolution>;
+
+    struct TextHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    // Entries beyond this are not worth keeping; the cache starts over.
+    static constexpr size_t MaxCachedResolutions = 1 << 16;
+
+    // Strict lookups search the partition of one keyword (Given, When, Then);
+    // AnyKeyword is every definition, for all other lookups.
+    static constexpr size_t AnyKeyword = 3;
+    size_t partitionOf(types::StepType keyword) const;
+    static bool inPartition(types::StepType type, size_t partition);
+
     std::vector<StepDefinitionPtr> steps;
-    StepRegistry() = default;
+    types::MatchStrategy m_strategy = types::MatchStrategy::Tiered;
+    types::RegexBackend m_backend = types::RegexBackend::Builtin;
+    bool m_strict = false;
+    // Find the candidate definitions for a text without trying every regex:
+    // one index per keyword partition, AnyKeyword last.
+    std::array<std::unique_ptr<matching::StepIndex>, AnyKeyword + 1> m_indexes;
+    // Built when the Automaton strategy is selected. Definitions it cannot
+    // compile are listed in m_unsupported and tried one by one.
+    std::unique_ptr<matching::Automaton> m_automaton;
+    std::vector<uint32_t> m_unsupported;
+    mutable std::shared_mutex m_cacheMutex;
+    // One resolution cache per partition
+    mutable std::array<std::unordered_map<std::string, ResolutionPtr, TextHash, std::equal_to<>>, AnyKeyword + 1>
+        m_resolutions;
+    mutable std::atomic<uint64_t> m_hits{ 0 };
+    mutable std::atomic<uint64_t> m_misses{ 0 };
 
-    // Heuristic: count literals and tokens to rank specificity
-    int computeSpecificity(const std::string& pat) const
+    StepRegistry();
+    ~StepRegistry();
+
+    void addStep(StepDefinitionPtr step);
+
+    template <typename DerivedContext, typename Callback>
+    static StepDefinitionPtr makeDefinition(types::StepType type, std::string patternStr, Callback callback)
     {
-        int score = 0;
-        size_t pos = 0;
-        while (pos < pat.size())
+        // Wrap user callback: grab the singleton and dispatch
+        auto wrapper = [callback](const CaptureList& args)
         {
-            if (pat.compare(pos, 2, "\\d") == 0)
-            {
-                score += 2;
-                pos += 2;
-            }
-            else if (pat.compare(pos, 2, "\\w") == 0)
-            {
-                score += 1;
-                pos += 2;
-            }
-            else if (pat[pos] == '^' || pat[pos] == '$')
-            {
-                score += 3;
-                pos += 1;
-            }
-            else if (pat[pos] == '[')
-            {
-                auto end = pat.find(']', pos);
-                if (end != std::string::npos)
-                {
-                    int len = static_cast<int>(end - pos - 1);
-                    score += (len > 0 ? len : 1);
-                    pos = end + 1;
-                }
-                else
-                {
-                    pos++;
-                }
-            }
-            else if (std::isalnum(static_cast<unsigned char>(pat[pos])))
-            {
-                score += 4;
-                pos++;
-            }
-            else
-            {
-                pos++;
-            }
-        }
-        return score;
+            auto& ctx = DerivedContext::getInstance();
+            callWithArgs(callback, ctx, args);
+        };
+
+        auto stepDef = std::make_shared<StepDefinition>();
+        stepDef->type = type;
+        stepDef->patternStr = std::move(patternStr);
+        stepDef->func = std::move(wrapper);
+        stepDef->prepare = [callback](const CaptureList& args)
+        { return prepareCall<DerivedContext>(callback, args, std::make_index_sequence<argumentCount<Callback>()>{}); };
+        return stepDef;
     }
+    void run(const Resolution& resolution, std::string_view stepText) const;
+    ResolutionPtr resolve(std::string_view stepText, size_t partition) const;
+    ResolutionPtr match(std::string_view stepText, size_t partition) const;
+    ResolutionPtr matchLinear(std::string_view stepText, size_t partition) const;
+    void addToAutomaton(uint32_t id);
+
+    // A definition that may match a text, and whether it is known to.
+    struct Candidate
+    {
+        uint32_t id;
+        bool matches;
+    };
+    ResolutionPtr pickBest(std::string_view stepText, std::vector<Candidate>& candidates) const;
+
+    // Heuristic: count literals and tokens to rank specificity
+    static int computeSpecificity(const std::string& pat);
 
     // Unpack and convert args, dropping the first tuple element (the context)
     template <typename Callback, typename DerivedContext>
-    static void callWithArgs(Callback callback, DerivedContext& ctx, const std::vector<std::string>& args)
+    static void callWithArgs(Callback callback, DerivedContext& ctx, const CaptureList& args)
     {
         using Functor = std::remove_reference_t<Callback>;
         using Traits = function_traits<decltype(&Functor::operator())>;
@@ -225,14 +304,50 @@ private:
     static void callHelperImpl(
         Callback callback,
         DerivedContext& ctx,
-        const std::vector<std::string>& args,
+        const CaptureList& args,
         std::index_sequence<I...>)
     {
         using Functor = std::remove_reference_t<Callback>;
         using Traits = function_traits<decltype(&Functor::operator())>;
         using Tuple = typename Traits::args_tuple;
 
-        callback(ctx, convert<typename std::tuple_element<I + 1, Tuple>::type>(args[I])...);
+        callback(ctx, argument<std::decay_t<typename std::tuple_element<I + 1, Tuple>::type>>(args, I)...);
+    }
+
+    template <typename Callback> static constexpr size_t argumentCount()
+    {
+        using Functor = std::remove_reference_t<Callback>;
+        return std::tuple_size_v<typename function_traits<decltype(&Functor::operator())>::args_tuple> - 1;
+    }
+
+    // Converts every capture now; the returned call only fetches the context.
+    template <typename DerivedContext, typename Callback, size_t... I>
+    static std::function<void()> prepareCall(Callback callback, const CaptureList& args, std::index_sequence<I...>)
+    {
+        using Functor = std::remove_reference_t<Callback>;
+        using Tuple = typename function_traits<decltype(&Functor::operator())>::args_tuple;
+        if (args.size() != sizeof...(I))
+        {
+            throw std::runtime_error("Argument count mismatch in step callback");
+        }
+        std::tuple<std::decay_t<std::tuple_element_t<I + 1, Tuple>>...> values{
+            argument<std::decay_t<std::tuple_element_t<I + 1, Tuple>>>(args, I)...
+        };
+        return [callback, values]() { callback(DerivedContext::getInstance(), std::get<I>(values)...); };
+    }
+
+    // Converts capture `index`, recording its position in any conversion error.
+    template <typename T> static T argument(const CaptureList& args, size_t index)
+    {
+        try
+        {
+            return convert<T>(args[index]);
+        }
+        catch (StepArgumentException& e)
+        {
+            e.setArgument(index);
+            throw;
+        }
     }
 };
 
@@ -0,0 +1,40 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace pep
+{
+
+/// Thrown by a step to fail its scenario: the behaviour under test is wrong.
+/// Runners report it as a failed scenario (exit code 42), and anything else a
+/// step throws as an error (exit code 2).
+class TestFailure : public std::runtime_error
+{
+public:
+    explicit TestFailure(const std::string& message) : std::runtime_error(message) {}
+};
+
+/// Fails the scenario with `message` unless `condition` holds.
+inline void check(bool condition, const std::string& message)
+{
+    if (!condition)
+        throw TestFailure(message);
+}
+
+} // namespace pep
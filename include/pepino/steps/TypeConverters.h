@@ -15,31 +15,267 @@
  *******************************************************************************/
 #pragma once
 
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <optional>
+#include <ratio>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace pep
 {
 
-// Primary template declaration (no definition)
-template <typename T> T convert(const std::string& str);
+/// Thrown when a capture cannot be converted to the type of its callback
+/// argument. Carries what failed so runners can report it without parsing
+/// the message.
+class StepArgumentException : public std::runtime_error
+{
+public:
+    static constexpr size_t UnknownArgument = static_cast<size_t>(-1);
+
+    StepArgumentException(std::string_view type, std::string_view text)
+        : std::runtime_error(""),
+          m_type(type),
+          m_text(text)
+    {
+        format();
+    }
+
+    const char* what() const noexcept override { return m_message.c_str(); }
+
+    /// The expected type, e.g. "integer".
+    const std::string& type() const { return m_type; }
+    /// The capture that failed to convert.
+    const std::string& text() const { return m_text; }
+    /// Zero-based position among the step's captures, or UnknownArgument.
+    size_t argument() const { return m_argument; }
+    /// The step text, once known.
+    const std::string& step() const { return m_step; }
+
+    void setArgument(size_t argument)
+    {
+        m_argument = argument;
+        format();
+    }
+
+    void setStep(std::string_view step)
+    {
+        m_step = step;
+        format();
+    }
+
+private:
+    void format()
+    {
+        m_message = "Cannot convert '" + m_text + "' to " + m_type;
+        if (m_argument != UnknownArgument)
+            m_message += " (argument " + std::to_string(m_argument + 1) + ")";
+        if (!m_step.empty())
+            m_message += " in step: " + m_step;
+    }
+
+    std::string m_type;
+    std::string m_text;
+    size_t m_argument = UnknownArgument;
+    std::string m_step;
+    std::string m_message;
+};
+
+/// Parses a capture into a callback argument of type T. Specialize it with a
+/// `name` and a `static bool parse(std::string_view, T&)` that returns false
+/// on malformed text, to accept new argument types. None of the built-in ones
+/// allocate except std::string, and none throw.
+template <typename T> struct Converter;
+
+namespace detail
+{
+// from_chars does not take the leading '+' that step texts often carry.
+inline std::string_view skipPlus(std::string_view text)
+{
+    if (text.size() > 1 && text.front() == '+' && text[1] != '-')
+        text.remove_prefix(1);
+    return text;
+}
+
+template <typename T> bool parseNumber(std::string_view text, T& value)
+{
+    text = skipPlus(text);
+    const char* end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc{} && ptr == end && !text.empty();
+}
+} // namespace detail
+
+template <typename T>
+    requires(std::integral<T> && !std::same_as<T, bool>)
+struct Converter<T>
+{
+    static constexpr std::string_view name = std::is_signed_v<T> ? "integer" : "unsigned integer";
+    static bool parse(std::string_view text, T& value) { return detail::parseNumber(text, value); }
+};
 
-// Specialization for int
-template <> inline int convert<int>(const std::string& str)
+template <std::floating_point T> struct Converter<T>
 {
-    return std::stoi(str);
+    static constexpr std::string_view name = "number";
+    static bool parse(std::string_view text, T& value) { return detail::parseNumber(text, value); }
+};
+
+template <> struct Converter<bool>
+{
+    static constexpr std::string_view name = "boolean";
+    static bool parse(std::string_view text, bool& value)
+    {
+        if (text == "true" || text == "yes" || text == "1")
+            value = true;
+        else if (text == "false" || text == "no" || text == "0")
+            value = false;
+        else
+            return false;
+        return true;
+    }
+};
+
+template <> struct Converter<std::string>
+{
+    static constexpr std::string_view name = "string";
+    static bool parse(std::string_view text, std::string& value)
+    {
+        value.assign(text);
+        return true;
+    }
+};
+
+// The capture itself, without a copy; it views the step text and is only
+// valid during the step.
+template <> struct Converter<std::string_view>
+{
+    static constexpr std::string_view name = "string";
+    static bool parse(std::string_view text, std::string_view& value)
+    {
+        value = text;
+        return true;
+    }
+};
+
+// A count with an optional unit: "250ms", "1.5 s", "2min". Without a unit the
+// count is in the duration's own period. Integer durations reject values
+// their period cannot hold exactly, such as "1500us" as milliseconds.
+template <typename Rep, typename Period> struct Converter<std::chrono::duration<Rep, Period>>
+{
+    using Duration = std::chrono::duration<Rep, Period>;
+    static constexpr std::string_view name = "duration";
+
+    static bool parse(std::string_view text, Duration& value)
+    {
+        size_t split = text.size();
+        while (split > 0 && ((text[split - 1] >= 'a' && text[split - 1] <= 'z') || text[split - 1] == ' '))
+            --split;
+        std::string_view unit = text.substr(split);
+        while (!unit.empty() && unit.front() == ' ')
+            unit.remove_prefix(1);
+
+        Rep count{};
+        if (!detail::parseNumber(text.substr(0, split), count))
+            return false;
+        if (unit.empty())
+            return assign<Period>(count, value);
+        if (unit == "ns")
+            return assign<std::nano>(count, value);
+        if (unit == "us")
+            return assign<std::micro>(count, value);
+        if (unit == "ms")
+            return assign<std::milli>(count, value);
+        if (unit == "s")
+            return assign<std::ratio<1>>(count, value);
+        if (unit == "min")
+            return assign<std::ratio<60>>(count, value);
+        if (unit == "h")
+            return assign<std::ratio<3600>>(count, value);
+        return false;
+    }
+
+private:
+    template <typename Unit> static bool assign(Rep count, Duration& value)
+    {
+        const std::chrono::duration<Rep, Unit> parsed(count);
+        value = std::chrono::duration_cast<Duration>(parsed);
+        if constexpr (std::is_floating_point_v<Rep>)
+            return true;
+        else
+            return std::chrono::duration_cast<std::chrono::duration<Rep, Unit>>(value) == parsed;
+    }
+};
+
+/// The names an enum is written as in step texts, registered with
+/// registerEnum or ENUM_NAMES. An enum without names converts from its
+/// underlying integer.
+template <typename E> std::vector<std::pair<std::string, E>>& enumNames()
+{
+    static std::vector<std::pair<std::string, E>> names;
+    return names;
 }
 
-// Specialization for double
-template <> inline double convert<double>(const std::string& str)
+/// Registers the names of enum E's values. Meant to be called during static
+/// initialisation, before any step runs.
+template <typename E> void registerEnum(std::initializer_list<std::pair<std::string_view, E>> names)
+{
+    for (const auto& [text, value] : names)
+        enumNames<E>().emplace_back(text, value);
+}
+
+template <typename E>
+    requires std::is_enum_v<E>
+struct Converter<E>
+{
+    static constexpr std::string_view name = "enum value";
+    static bool parse(std::string_view text, E& value)
+    {
+        const auto& names = enumNames<E>();
+        if (names.empty())
+        {
+            std::underlying_type_t<E> number{};
+            if (!detail::parseNumber(text, number))
+                return false;
+            value = static_cast<E>(number);
+            return true;
+        }
+        for (const auto& [candidate, enumerator] : names)
+        {
+            if (candidate == text)
+            {
+                value = enumerator;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/// The value of `text` as a T, or nullopt if it is malformed.
+template <typename T> std::optional<T> tryConvert(std::string_view text)
 {
-    return std::stod(str);
+    T value{};
+    if (!Converter<T>::parse(text, value))
+        return std::nullopt;
+    return value;
 }
 
-// Specialization for std::string (the identity function)
-template <> inline std::string convert<std::string>(const std::string& str)
+/// The value of `text` as a T; throws StepArgumentException if it is
+/// malformed. `text` views the step text and is only valid during the step.
+template <typename T> T convert(std::string_view text)
 {
-    return str;
+    T value{};
+    if (!Converter<T>::parse(text, value))
+        throw StepArgumentException(Converter<T>::name, text);
+    return value;
 }
 
 } // namespace pep
@@ -16,6 +16,7 @@
 #pragma once
 
 #include "StepRegistry.h"
+#include "TestFailure.h"
 #include "pepino/types/types.h"
 
 namespace pep
@@ -33,6 +34,55 @@ namespace pep
     }();                                                                                                               \
     }
 
+// Like STEP_CTX, with `pattern` (a string literal) compiled at build time: no
+// regex is built at startup, and a capture group count that differs from the
+// callback's argument count does not compile.
+#define CT_STEP_CTX(ctxType, stepType, pattern, callback)                                                              \
+    namespace                                                                                                          \
+    {                                                                                                                  \
+    const bool TOKEN_PASTE2(_step_reg_, __COUNTER__) = []()                                                            \
+    {                                                                                                                  \
+        pep::StepRegistry::getInstance().registerStaticStep<ctxType, pattern>(stepType, callback);                     \
+        return true;                                                                                                   \
+    }();                                                                                                               \
+    }
+
+// Defines the Cucumber Expression parameter type {name}; see
+// StepRegistry::defineParameterType.
+#define PARAMETER_TYPE(name, accepts)                                                                                  \
+    namespace                                                                                                          \
+    {                                                                                                                  \
+    const bool TOKEN_PASTE2(_param_type_, __COUNTER__) = []()                                                          \
+    {                                                                                                                  \
+        pep::StepRegistry::getInstance().defineParameterType(name, accepts);                                           \
+        return true;                                                                                                   \
+    }();                                                                                                               \
+    }
+
+// Defines the Cucumber Expression parameter type {name} as the texts that
+// convert to `type`.
+#define PARAMETER_TYPE_OF(name, type)                                                                                  \
+    namespace                                                                                                          \
+    {                                                                                                                  \
+    const bool TOKEN_PASTE2(_param_type_, __COUNTER__) = []()                                                          \
+    {                                                                                                                  \
+        pep::StepRegistry::getInstance().defineParameterType<type>(name);                                              \
+        return true;                                                                                                   \
+    }();                                                                                                               \
+    }
+
+// Names the values of an enum in step texts:
+// ENUM_NAMES(Color, { "red", Color::Red }, { "green", Color::Green })
+#define ENUM_NAMES(type, ...)                                                                                          \
+    namespace                                                                                                          \
+    {                                                                                                                  \
+    const bool TOKEN_PASTE2(_enum_names_, __COUNTER__) = []()                                                          \
+    {                                                                                                                  \
+        pep::registerEnum<type>({ __VA_ARGS__ });                                                                      \
+        return true;                                                                                                   \
+    }();                                                                                                               \
+    }
+
 /// — the “new” form, when you want to explicitly say which Context to use:
 #define GIVEN_CTX(ctx, pat, cb) STEP_CTX(ctx, pep::types::StepType::Given, pat, cb)
 #define WHEN_CTX(ctx, pat, cb) STEP_CTX(ctx, pep::types::StepType::When, pat, cb)
@@ -47,4 +97,16 @@ namespace pep
 #define AND(pat, cb) AND_CTX(pep::DefaultContext, pat, cb)
 #define BUT(pat, cb) BUT_CTX(pep::DefaultContext, pat, cb)
 
+#define CT_GIVEN_CTX(ctx, pat, cb) CT_STEP_CTX(ctx, pep::types::StepType::Given, pat, cb)
+#define CT_WHEN_CTX(ctx, pat, cb) CT_STEP_CTX(ctx, pep::types::StepType::When, pat, cb)
+#define CT_THEN_CTX(ctx, pat, cb) CT_STEP_CTX(ctx, pep::types::StepType::Then, pat, cb)
+#define CT_AND_CTX(ctx, pat, cb) CT_STEP_CTX(ctx, pep::types::StepType::And, pat, cb)
+#define CT_BUT_CTX(ctx, pat, cb) CT_STEP_CTX(ctx, pep::types::StepType::But, pat, cb)
+
+#define CT_GIVEN(pat, cb) CT_GIVEN_CTX(pep::DefaultContext, pat, cb)
+#define CT_WHEN(pat, cb) CT_WHEN_CTX(pep::DefaultContext, pat, cb)
+#define CT_THEN(pat, cb) CT_THEN_CTX(pep::DefaultContext, pat, cb)
+#define CT_AND(pat, cb) CT_AND_CTX(pep::DefaultContext, pat, cb)
+#define CT_BUT(pat, cb) CT_BUT_CTX(pep::DefaultContext, pat, cb)
+
 } // namespace pep
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace pep::types
@@ -30,10 +31,36 @@ enum class StepType
     But
 };
 
+// How StepRegistry finds the definition a step text resolves to. Every
+// strategy picks the same definition; they differ in cost.
+enum class MatchStrategy
+{
+    Linear,   // Try every definition's regex in turn
+    Tiered,   // Look up literal patterns and prefixes first, then the rest
+    Automaton // Run all patterns at once as one lazily built DFA
+};
+
+// The regex engine behind step patterns.
+enum class RegexBackend
+{
+    Builtin, // Linear-time Pike VM; falls back to std::regex for syntax it lacks
+    StdRegex // std::regex for every pattern
+};
+
+// How long the Context instances that steps receive live.
+enum class ContextLifetime
+{
+    Shared,   // One process-wide instance per context type, never reset
+    Scenario, // A fresh instance for every scenario
+    Pooled    // Per scenario, with contexts that have reset() recycled through a pool
+};
+
+// `name` views the step text being run and is only valid for the duration of
+// the hook call; copy it if it has to outlive the hook.
 struct StepInfo
 {
     StepType type;
-    std::string name;
+    std::string_view name;
 };
 
 struct FeatureInfo
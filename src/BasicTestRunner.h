@@ -15,61 +15,36 @@
  *******************************************************************************/
 #pragma once
 
+#include "ExecutionPlan.h"
 #include "ITestRunner.h"
-#include "parsing/Statement.h"
+#include "parsing/FlatFeature.h"
 #include "pepino/types/types.h"
 
-#include <exception>
 #include <vector>
 
 namespace pep
 {
-// BasicTestRunner implements ITestRunner by querying the StepRegistry
-// singleton. It looks for a callback associated with the provided test name (or
-// step name) and invokes it if found.
+// BasicTestRunner implements ITestRunner on top of the StepRegistry
+// singleton. A feature is first compiled into an ExecutionPlan, so every step
+// is bound to its callback before the first one runs; undefined or ambiguous
+// steps fail the feature without running anything. Unless `lifetime` is
+// Shared, every scenario gets contexts of its own.
 class BasicTestRunner : public ITestRunner
 {
 public:
-    int runTests(std::unique_ptr<FeatureStatement> feature) const override;
+    explicit BasicTestRunner(types::ContextLifetime lifetime = types::ContextLifetime::Scenario);
 
-private:
-    // Runs the entire feature (background, scenarios, scenario outlines)
-    void runFeature(const FeatureStatement& feature) const;
-    // Run a single scenario (with an optional background)
-    void runScenario(const ScenarioStatement& scenario) const;
-    void runScenario(const ScenarioStatement& scenario, const BackgroundStatement& background) const;
-
-    // Run a single scenario outline (with an optional background)
-    void runScenarioOutline(const ScenarioOutlineStatement& scenarioOutline) const;
-    void
-    runScenarioOutline(const ScenarioOutlineStatement& scenarioOutline, const BackgroundStatement& background) const;
-
-    // Run a single step from a step statement
-    void runStep(const StepStatement& step) const;
-
-    // Run a step given a substituted step text (for scenario outlines)
-    void runStep(const types::StepType& type, const std::string& substitutedStepText) const;
+    // Runs the plans one after the other. A feature stops at its first
+    // failing scenario; the next feature still runs.
+    int runPlans(const std::vector<ExecutionPlan>& plans, std::vector<ScenarioResult>* results) const override;
 
-    // Helper: Substitute placeholders in a step text using the provided
-    // mapping.
-    std::string
-    substitutePlaceholders(const std::vector<Token>& text, const std::unordered_map<std::string, std::string>& mapping)
-        const;
-
-public:
-    // Custom exception for test failures
-    class TestFailedException : public std::exception
-    {
-    public:
-        explicit TestFailedException(const std::string& message)
-            : m_message(message)
-        {
-        }
-        const char* what() const noexcept override { return m_message.c_str(); }
+private:
+    // Runs every scenario of the plan, with its hooks
+    void runPlan(const ExecutionPlan& plan, std::vector<ScenarioResult>* results) const;
+    // Runs one pre-bound step
+    void runStep(const ExecutionPlan::Step& step) const;
 
-    private:
-        std::string m_message;
-    };
+    types::ContextLifetime m_lifetime;
 };
 
 } // namespace pep
@@ -0,0 +1,274 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "ExecutionPlan.h"
+
+#include "Logger.h"
+#include "pepino/steps/StepRegistry.h"
+
+#include <type_traits>
+#include <unordered_map>
+
+namespace pep
+{
+
+static_assert(std::is_nothrow_move_constructible_v<ExecutionPlan>);
+
+namespace
+{
+std::vector<std::string> tagStrings(const FlatFeature& feature, FlatFeature::Range tags)
+{
+    std::vector<std::string> strings;
+    strings.reserve(tags.count);
+    for (auto i = tags.first; i < tags.end(); ++i)
+    {
+        strings.emplace_back(feature.tagText[i].view());
+    }
+    return strings;
+}
+} // namespace
+
+ExecutionPlan ExecutionPlan::compile(const FlatFeature& feature, std::string_view source)
+{
+    ExecutionPlan plan;
+    plan.m_feature = { std::string(feature.name.view()), tagStrings(feature, feature.tags) };
+    std::unordered_map<std::string, uint32_t> seen; // Scenarios per name, for unique ids
+    for (Index scenario = 0; scenario < feature.scenarioCount(); ++scenario)
+    {
+        const std::string name(feature.scenarioName[scenario].view());
+        std::string id = (source.empty() ? plan.m_feature.name : std::string(source)) + "/" + name;
+        if (const uint32_t count = ++seen[name]; count > 1)
+        {
+            id += "#" + std::to_string(count);
+        }
+        if (feature.scenarioOutline[scenario])
+        {
+            plan.addOutline(feature, scenario, id);
+            continue;
+        }
+        plan.addScenario(std::move(id),
+                         { name, tagStrings(feature, feature.scenarioTags[scenario]) },
+                         "Running Scenario: " + name);
+        if (feature.hasBackground)
+        {
+            plan.addSteps(feature, feature.background);
+        }
+        plan.addSteps(feature, feature.scenarioSteps[scenario]);
+    }
+    plan.bind();
+    return plan;
+}
+
+void ExecutionPlan::addScenario(std::string id, types::ScenarioInfo info, std::string banner)
+{
+    m_scenarios.push_back(
+        { std::move(id), std::move(info), std::move(banner), static_cast<uint32_t>(m_steps.size()), 0 });
+}
+
+void ExecutionPlan::retain(const std::function<bool(const std::string& id)>& keep)
+{
+    std::erase_if(m_scenarios, [&](const Scenario& scenario) { return !keep(scenario.id); });
+    for (auto& problem : m_problems)
+    {
+        std::erase_if(problem.ids, [&](const std::string& id) { return !keep(id); });
+    }
+    std::erase_if(m_problems, [](const Problem& problem) { return problem.ids.empty(); });
+}
+
+size_t ExecutionPlan::logProblems(const std::vector<ExecutionPlan>& plans)
+{
+    size_t count = 0;
+    for (const auto& plan : plans)
+    {
+        for (const auto& problem : plan.problems())
+        {
+            Logger::error(problem.scenario + ": " + problem.message + (problem.step.empty() ? "" : ": " + problem.step));
+        }
+        count += plan.problems().size();
+    }
+    return count;
+}
+
+void ExecutionPlan::addStep(types::StepType type, std::string_view text)
+{
+    // And and But continue the keyword of the step before them in the same
+    // scenario, background included; at the start they count as Given.
+    types::StepType keyword = type;
+    if (type == types::StepType::And || type == types::StepType::But)
+    {
+        const auto& scenario = m_scenarios.back();
+        keyword = scenario.stepCount > 0 ? m_steps.back().keyword : types::StepType::Given;
+    }
+    m_steps.push_back({ type, keyword, text, nullptr });
+    ++m_scenarios.back().stepCount;
+}
+
+// Literal steps; placeholders are only bound inside scenario outlines.
+void ExecutionPlan::addSteps(const FlatFeature& feature, FlatFeature::Range steps)
+{
+    for (auto step = steps.first; step < steps.end(); ++step)
+    {
+        const auto tokens = feature.stepTokens[step];
+        bool literal = true;
+        for (auto token = tokens.first; token < tokens.end() && literal; ++token)
+        {
+            if (feature.tokenType[token] == TokenType::Placeholder)
+            {
+                m_problems.push_back({ m_scenarios.back().info.name,
+                                       "",
+                                       "Step contains unbound placeholder: " +
+                                           std::string(feature.tokenText[token].view()),
+                                       { m_scenarios.back().id } });
+                literal = false;
+            }
+        }
+        if (literal)
+        {
+            addStep(feature.stepType[step], feature.stepText[step].view());
+        }
+    }
+}
+
+// One scenario per example row. Each <header> is replaced with the cell of the
+// row in the same column.
+void ExecutionPlan::addOutline(const FlatFeature& feature, Index scenario, const std::string& id)
+{
+    const std::string name(feature.scenarioName[scenario].view());
+    const Index examples = feature.scenarioExamples[scenario];
+    if (examples == FlatFeature::None)
+    {
+        m_problems.push_back({ name, "", "Scenario Outline has no Examples", { id } });
+        return;
+    }
+    const auto headers = feature.examplesHeaders[examples];
+    const auto rows = feature.examplesRows[examples];
+    const auto steps = feature.scenarioSteps[scenario];
+    const auto tags = tagStrings(feature, feature.scenarioTags[scenario]);
+    for (auto row = rows.first; row < rows.end(); ++row)
+    {
+        const auto cells = feature.rowCells[row];
+        if (cells.count != headers.count)
+        {
+            Logger::warn("In Scenario Outline '" + name + "', header count and row size do not match.");
+            continue;
+        }
+        std::string banner = "Running Scenario Outline: " + name + " with mapping: ";
+        for (Index i = 0; i < headers.count; ++i)
+        {
+            banner.append("<")
+                .append(feature.cellText[headers.first + i].view())
+                .append(">=")
+                .append(feature.cellText[cells.first + i].view())
+                .append(" ");
+        }
+        addScenario(id + "/" + std::to_string(row - rows.first + 1), { name, tags }, std::move(banner));
+        if (feature.hasBackground)
+        {
+            addSteps(feature, feature.background);
+        }
+
+        for (auto step = steps.first; step < steps.end(); ++step)
+        {
+            std::string& literal = m_texts->emplace_back();
+            const auto tokens = feature.stepTokens[step];
+            auto token = tokens.first;
+            for (; token < tokens.end(); ++token)
+            {
+                if (token != tokens.first)
+                {
+                    literal.push_back(' ');
+                }
+                const Symbol text = feature.tokenText[token];
+                if (feature.tokenType[token] != TokenType::Placeholder)
+                {
+                    literal.append(text.view());
+                    continue;
+                }
+                // Headers and placeholders are interned, so finding the column
+                // is a run of integer compares.
+                Index column = 0;
+                while (column < headers.count && feature.cellText[headers.first + column] != text)
+                {
+                    ++column;
+                }
+                if (column == headers.count)
+                {
+                    m_problems.push_back(
+                        { name, "", "Unbound placeholder: " + std::string(text.view()), { m_scenarios.back().id } });
+                    break;
+                }
+                literal.append(feature.cellText[cells.first + column].view());
+            }
+            if (token == tokens.end())
+            {
+                addStep(feature.stepType[step], literal);
+            }
+        }
+    }
+}
+
+// Binds every step, reporting each failing text once however often it occurs,
+// with the ids of every scenario it occurs in.
+void ExecutionPlan::bind()
+{
+    const auto& registry = StepRegistry::getInstance();
+    std::unordered_map<std::string_view, size_t> reported; // Step text to its problem
+    for (const auto& scenario : m_scenarios)
+    {
+        for (uint32_t i = scenario.firstStep; i < scenario.firstStep + scenario.stepCount; ++i)
+        {
+            Step& step = m_steps[i];
+            std::string message;
+            try
+            {
+                auto bound = registry.bindStep(step.keyword, step.text);
+                if (bound.pattern.empty())
+                {
+                    message = "Undefined step";
+                }
+                else if (!bound.ambiguousWith.empty())
+                {
+                    message = "Ambiguous step, matched by '" + bound.pattern + "'";
+                    for (const auto& other : bound.ambiguousWith)
+                    {
+                        message += " and '" + other + "'";
+                    }
+                }
+                else
+                {
+                    step.call = std::move(bound.call);
+                    continue;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                message = e.what();
+            }
+            const auto [it, added] = reported.try_emplace(step.text, m_problems.size());
+            if (added)
+            {
+                m_problems.push_back({ scenario.info.name, std::string(step.text), std::move(message), {} });
+            }
+            auto& ids = m_problems[it->second].ids;
+            if (ids.empty() || ids.back() != scenario.id)
+            {
+                ids.push_back(scenario.id);
+            }
+        }
+    }
+}
+
+} // namespace pep
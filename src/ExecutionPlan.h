@@ -0,0 +1,122 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "parsing/FlatFeature.h"
+#include "pepino/types/types.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pep
+{
+
+// A feature compiled for running. Outlines are expanded into one scenario per
+// example row, the background is inlined into every scenario, and each step is
+// bound to its definition with its arguments already converted. Steps that
+// cannot run (undefined, ambiguous, bad arguments, unbound placeholders) are
+// collected as problems up front rather than found halfway through the run.
+// Running the plan is then a loop over pre-bound calls.
+class ExecutionPlan
+{
+public:
+    struct Step
+    {
+        types::StepType type;    // As written
+        types::StepType keyword; // Given, When or Then; And/But take the one before them
+        std::string_view text;   // Interned or owned by the plan
+        std::function<void()> call;
+    };
+
+    struct Scenario
+    {
+        // Stable across runs and machines while the feature is unchanged:
+        // "source/Scenario", with "#2" for a second scenario of the same
+        // name and "/3" for the third row of an outline. The source is the
+        // feature file's path, or the feature's name if there is none.
+        std::string id;
+        types::ScenarioInfo info;
+        std::string banner; // Printed when the scenario starts
+        uint32_t firstStep = 0;
+        uint32_t stepCount = 0;
+    };
+
+    struct Problem
+    {
+        std::string scenario;
+        std::string step;
+        std::string message;
+        // The scenarios it keeps from running; for an outline without
+        // examples, which has none, the outline's own id.
+        std::vector<std::string> ids;
+    };
+
+    // `source` is the path of the feature file, which makes the scenario ids
+    // of a run unique even if two files have a feature of the same name.
+    static ExecutionPlan compile(const FlatFeature& feature, std::string_view source = {});
+
+    // Steps view texts the plan owns, so a copy would view the original's.
+    // Moving keeps them where they are, and cannot throw, so vectors of plans
+    // move rather than copy them when they grow.
+    ExecutionPlan(const ExecutionPlan&) = delete;
+    ExecutionPlan& operator=(const ExecutionPlan&) = delete;
+    ExecutionPlan(ExecutionPlan&&) noexcept = default;
+    ExecutionPlan& operator=(ExecutionPlan&&) noexcept = default;
+
+    const types::FeatureInfo& feature() const { return m_feature; }
+    const std::vector<Scenario>& scenarios() const { return m_scenarios; }
+    std::span<const Step> steps(const Scenario& scenario) const
+    {
+        return { m_steps.data() + scenario.firstStep, scenario.stepCount };
+    }
+    // Empty when every step is bound.
+    const std::vector<Problem>& problems() const { return m_problems; }
+
+    // Keeps only the scenarios whose id `keep` accepts, as when running one
+    // shard of a suite, and the problems of those scenarios.
+    void retain(const std::function<bool(const std::string& id)>& keep);
+
+    // Logs the problems of every plan and returns how many there are.
+    static size_t logProblems(const std::vector<ExecutionPlan>& plans);
+
+private:
+    using Index = FlatFeature::Index;
+
+    ExecutionPlan() = default;
+
+    void addScenario(std::string id, types::ScenarioInfo info, std::string banner);
+    void addStep(types::StepType type, std::string_view text);
+    void addSteps(const FlatFeature& feature, FlatFeature::Range steps);
+    void addOutline(const FlatFeature& feature, Index scenario, const std::string& id);
+    void bind();
+
+    types::FeatureInfo m_feature;
+    std::vector<Scenario> m_scenarios;
+    std::vector<Step> m_steps;
+    std::vector<Problem> m_problems;
+    // Texts of substituted outline steps. A deque never moves its elements,
+    // and the plan only moves the pointer to it, so the views in m_steps stay
+    // valid however the plan is moved.
+    std::unique_ptr<std::deque<std::string>> m_texts = std::make_unique<std::deque<std::string>>();
+};
+
+} // namespace pep
@@ -134,7 +134,7 @@ void HookRegistry::registerBeforeStep(std::function<void(const types::StepInfo&)
 
 void HookRegistry::executeBeforeStep(const types::StepInfo& step)
 {
-    Logger::info("Before step: " + step.name);
+    Logger::info("Before step: " + std::string(step.name));
     if (m_beforeStepHook)
     {
         m_beforeStepHook(step);
@@ -158,7 +158,7 @@ void HookRegistry::registerAfterStep(std::function<void(const types::StepInfo&)>
 
 void HookRegistry::executeAfterStep(const types::StepInfo& step)
 {
-    Logger::info("After step: " + step.name);
+    Logger::info("After step: " + std::string(step.name));
     if (m_afterStepHook)
     {
         m_afterStepHook(step);
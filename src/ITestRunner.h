@@ -15,8 +15,14 @@
  *******************************************************************************/
 #pragma once
 
+#include "ExecutionPlan.h"
+#include "ScenarioResult.h"
+#include "parsing/FlatFeature.h"
 #include "parsing/Statement.h"
+
+#include <iostream>
 #include <memory>
+#include <vector>
 
 namespace pep
 {
@@ -28,7 +34,40 @@ class ITestRunner
 {
 public:
     virtual ~ITestRunner() = default;
-    virtual int runTests(std::unique_ptr<FeatureStatement> feature) const = 0;
+
+    // Runs compiled plans. Nothing runs if any plan has problems. The result
+    // of every scenario that ran is appended to `results` if given. Returns 0
+    // on success, otherwise the code of the first failure.
+    virtual int runPlans(const std::vector<ExecutionPlan>& plans, std::vector<ScenarioResult>* results) const = 0;
+
+    // Compiles the features and runs their plans together.
+    int runTests(const std::vector<FlatFeature>& features) const
+    {
+        std::vector<ExecutionPlan> plans;
+        plans.reserve(features.size());
+        for (const auto& feature : features)
+        {
+            plans.push_back(ExecutionPlan::compile(feature));
+        }
+        return runPlans(plans, nullptr);
+    }
+
+    int runTests(const FlatFeature& feature) const
+    {
+        std::vector<ExecutionPlan> plans;
+        plans.push_back(ExecutionPlan::compile(feature));
+        return runPlans(plans, nullptr);
+    }
+
+    int runTests(std::unique_ptr<FeatureStatement> feature) const
+    {
+        if (!feature)
+        {
+            std::cerr << "No feature to run." << std::endl;
+            return 1; // failure (no feature)
+        }
+        return runTests(FlatFeature::flatten(*feature));
+    }
 };
 
 } // namespace pep
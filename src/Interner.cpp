@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "Interner.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace pep
+{
+
+Interner& Interner::global()
+{
+    static Interner interner;
+    return interner;
+}
+
+Interner::Interner()
+{
+    // Symbol{} is the empty string.
+    block(0)[0] = std::string_view();
+}
+
+Interner::~Interner()
+{
+    for (auto& entry : m_blocks)
+    {
+        delete[] entry.load(std::memory_order_relaxed);
+    }
+}
+
+std::string_view* Interner::block(size_t index)
+{
+    std::string_view* current = m_blocks[index].load(std::memory_order_acquire);
+    if (current)
+    {
+        return current;
+    }
+    auto* fresh = new std::string_view[BlockSize];
+    if (m_blocks[index].compare_exchange_strong(current, fresh, std::memory_order_acq_rel))
+    {
+        return fresh;
+    }
+    delete[] fresh; // Another thread published the block first.
+    return current;
+}
+
+Symbol Interner::intern(std::string_view text)
+{
+    if (text.empty())
+    {
+        return Symbol();
+    }
+    Shard& shard = m_shards[std::hash<std::string_view>{}(text) % ShardCount];
+    std::lock_guard lock(shard.mutex);
+    if (auto it = shard.ids.find(text); it != shard.ids.end())
+    {
+        return Symbol(it->second);
+    }
+
+    const uint32_t id = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (id >= MaxBlocks * BlockSize)
+    {
+        throw std::length_error("Too many interned strings");
+    }
+    auto* copy = static_cast<char*>(shard.text.allocate(text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    const std::string_view stored(copy, text.size());
+    block(id >> BlockBits)[id & (BlockSize - 1)] = stored;
+    shard.ids.emplace(stored, id);
+    return Symbol(id);
+}
+
+std::string_view Interner::view(Symbol symbol) const
+{
+    // Whoever handed out `symbol` published its slot before doing so.
+    const std::string_view* entries = m_blocks[symbol.m_id >> BlockBits].load(std::memory_order_acquire);
+    return entries[symbol.m_id & (BlockSize - 1)];
+}
+
+} // namespace pep
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+
+namespace pep
+{
+
+// An interned string: a 32-bit ID for text stored once in the global Interner.
+// Equal texts always get the same symbol, so comparing symbols is an integer
+// compare, and the text they view stays valid for the rest of the process.
+class Symbol
+{
+public:
+    // The empty string.
+    constexpr Symbol() = default;
+
+    std::string_view view() const;
+    uint32_t id() const { return m_id; }
+    bool empty() const { return m_id == 0; }
+
+    bool operator==(const Symbol&) const = default;
+    friend bool operator==(Symbol symbol, std::string_view text) { return symbol.view() == text; }
+    friend std::ostream& operator<<(std::ostream& out, Symbol symbol) { return out << symbol.view(); }
+
+private:
+    friend class Interner;
+    explicit constexpr Symbol(uint32_t id) : m_id(id) {}
+
+    uint32_t m_id = 0;
+};
+
+// The process-wide string table. Interning is thread-safe and locks one of a
+// few shards, so features parsed in parallel rarely wait on each other;
+// looking a symbol's text up takes no lock at all.
+class Interner
+{
+public:
+    static Interner& global();
+
+    Symbol intern(std::string_view text);
+    std::string_view view(Symbol symbol) const;
+    // Number of distinct strings interned so far, the empty string included.
+    size_t size() const { return m_next.load(std::memory_order_relaxed); }
+
+    ~Interner();
+
+private:
+    Interner();
+
+    static constexpr size_t ShardCount = 16;
+    static constexpr size_t BlockBits = 12;
+    static constexpr size_t BlockSize = size_t{ 1 } << BlockBits;
+    static constexpr size_t MaxBlocks = 4096;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::pmr::monotonic_buffer_resource text;
+        std::unordered_map<std::string_view, uint32_t> ids;
+    };
+
+    std::string_view* block(size_t index);
+
+    // ID -> text, in fixed-size blocks that never move once published.
+    std::array<std::atomic<std::string_view*>, MaxBlocks> m_blocks{};
+    std::atomic<uint32_t> m_next{ 1 };
+    std::array<Shard, ShardCount> m_shards;
+};
+
+inline std::string_view Symbol::view() const
+{
+    return Interner::global().view(*this);
+}
+
+// Shorthand for Interner::global().intern(text).
+inline Symbol intern(std::string_view text)
+{
+    return Interner::global().intern(text);
+}
+
+} // namespace pep
+
+template <> struct std::hash<pep::Symbol>
+{
+    size_t operator()(pep::Symbol symbol) const noexcept { return std::hash<uint32_t>{}(symbol.id()); }
+};
@@ -16,6 +16,7 @@
 
 #include "Logger.h"
 
+#include <mutex>
 #include <unordered_map>
 
 namespace pep
@@ -73,6 +74,9 @@ void Logger::log(LogLevel level, std::string_view data)
         {LogLevel::Info, colorMap.at(Color::Blue)},
         {LogLevel::Warn, colorMap.at(Color::Yellow)},
         {LogLevel::Error, colorMap.at(Color::Red)}};
+    // Features are parsed on several threads; keep their lines whole.
+    static std::mutex mutex;
+    std::lock_guard lock(mutex);
     const auto levelStr = levelToString[level];
     std::cout << levelToColorString[level] << "[" << centerString(levelStr, 7)
               << "]\t" << data << colorMap.at(Color::Reset) << std::endl;
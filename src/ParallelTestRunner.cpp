@@ -0,0 +1,176 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "ParallelTestRunner.h"
+
+#include "Logger.h"
+#include "pepino/context.h"
+#include "pepino/hooks/HookRegistry.h"
+#include "pepino/steps/TestFailure.h"
+
+#include <iostream>
+#include <iterator>
+#include <optional>
+
+namespace pep
+{
+
+ParallelTestRunner::ParallelTestRunner(size_t threads, types::ContextLifetime lifetime)
+    : m_threads(threads), m_lifetime(lifetime)
+{
+}
+
+int ParallelTestRunner::runPlans(const std::vector<ExecutionPlan>& plans, std::vector<ScenarioResult>* results) const
+{
+    if (const size_t problems = ExecutionPlan::logProblems(plans); problems > 0)
+    {
+        std::cerr << "Test failed: " << problems << " step(s) cannot run" << std::endl;
+        return 42; // failure (test failed)
+    }
+
+    try
+    {
+        std::vector<const ExecutionPlan*> pointers;
+        for (const auto& plan : plans)
+        {
+            pointers.push_back(&plan);
+        }
+        WorkStealingScheduler::Stats stats;
+        auto scenarioResults = schedule(pointers, &stats);
+
+        // The result is that of the first scenario that did not pass.
+        int ret = 0;
+        size_t next = 0;
+        for (const auto& plan : plans)
+        {
+            for (const auto& scenario : plan.scenarios())
+            {
+                const auto& result = scenarioResults[next++];
+                std::cout << scenario.banner << std::endl;
+                if (result.status != ScenarioResult::Status::Passed)
+                {
+                    std::cerr << "Test failed: " << result.message << std::endl;
+                    if (ret == 0)
+                    {
+                        ret = result.exitCode();
+                    }
+                }
+            }
+        }
+        std::cout << stats.summary() << std::endl;
+        if (results)
+        {
+            std::move(scenarioResults.begin(), scenarioResults.end(), std::back_inserter(*results));
+        }
+        return ret;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Caught exception: " << e.what() << std::endl;
+        return 2; // failure (exception caught)
+    }
+}
+
+std::vector<ScenarioResult> ParallelTestRunner::runPlan(const ExecutionPlan& plan) const
+{
+    return schedule({ &plan });
+}
+
+std::vector<ScenarioResult> ParallelTestRunner::schedule(const std::vector<const ExecutionPlan*>& plans,
+                                                         WorkStealingScheduler::Stats* stats) const
+{
+    // One task per scenario of every plan, in plan order.
+    struct Task
+    {
+        const ExecutionPlan* plan;
+        const ExecutionPlan::Scenario* scenario;
+    };
+    std::vector<Task> tasks;
+    for (const ExecutionPlan* plan : plans)
+    {
+        for (const auto& scenario : plan->scenarios())
+        {
+            tasks.push_back({ plan, &scenario });
+        }
+    }
+    std::vector<ScenarioResult> results(tasks.size());
+
+    for (const ExecutionPlan* plan : plans)
+    {
+        HookRegistry::getInstance().executeBeforeAll(plan->feature());
+    }
+    // Each task writes its own slot, so no locking is needed.
+    const auto taskStats =
+        WorkStealingScheduler(m_threads).run(tasks.size(),
+                                             [&](size_t i) { results[i] = runScenario(*tasks[i].plan, *tasks[i].scenario, m_lifetime); });
+    for (const ExecutionPlan* plan : plans)
+    {
+        HookRegistry::getInstance().executeAfterAll(plan->feature());
+    }
+    if (stats)
+    {
+        *stats = taskStats;
+    }
+    return results;
+}
+
+ScenarioResult ParallelTestRunner::runScenario(const ExecutionPlan& plan,
+                                               const ExecutionPlan::Scenario& scenario,
+                                               types::ContextLifetime lifetime)
+{
+    ScenarioResult result;
+    result.id = scenario.id;
+    const auto start = std::chrono::steady_clock::now();
+    std::optional<ScenarioContexts> contexts;
+    std::optional<ScenarioContexts::Activation> active;
+    if (lifetime != types::ContextLifetime::Shared)
+    {
+        contexts.emplace(lifetime == types::ContextLifetime::Pooled);
+        active.emplace(*contexts);
+    }
+    auto& hooks = HookRegistry::getInstance();
+    try
+    {
+        hooks.executeBefore(scenario.info);
+        for (const auto& step : plan.steps(scenario))
+        {
+            types::StepInfo stepInfo{ step.type, step.text };
+            hooks.executeBeforeStep(stepInfo);
+            step.call();
+            hooks.executeAfterStep(stepInfo);
+        }
+        hooks.executeAfter(scenario.info);
+    }
+    catch (const TestFailure& e)
+    {
+        result.status = ScenarioResult::Status::Failed;
+        result.message = scenario.info.name + ": " + e.what();
+    }
+    catch (const std::exception& e)
+    {
+        result.status = ScenarioResult::Status::Error;
+        result.message = scenario.info.name + ": " + e.what();
+    }
+    catch (...)
+    {
+        result.status = ScenarioResult::Status::Error;
+        result.message = scenario.info.name + ": unknown exception";
+    }
+    result.duration = std::chrono::steady_clock::now() - start;
+    return result;
+}
+
+} // namespace pep
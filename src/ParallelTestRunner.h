@@ -0,0 +1,69 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "ExecutionPlan.h"
+#include "ITestRunner.h"
+#include "ScenarioResult.h"
+#include "WorkStealingScheduler.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace pep
+{
+
+// ParallelTestRunner runs scenarios, every outline row being one, on worker
+// threads with work stealing. The scenarios of all features given at once are
+// scheduled together, so a large feature is split across workers and a small
+// one does not hold the others up. A scenario runs its Before hook, its steps
+// and its After hook on one thread, with contexts of its own; the BeforeAll
+// hooks of all features run on the calling thread before any scenario, and
+// their AfterAll hooks after the last one. With a Shared context lifetime the
+// contexts are shared across threads as well, which only suits steps that do
+// not use them. A failing scenario does not stop the others. Results are
+// reported in plan order once every scenario is done, so the report does not
+// depend on scheduling; a summary of idle worker time follows.
+class ParallelTestRunner : public ITestRunner
+{
+public:
+    // 0 threads means one per hardware thread.
+    explicit ParallelTestRunner(size_t threads = 0,
+                                types::ContextLifetime lifetime = types::ContextLifetime::Scenario);
+
+    int runPlans(const std::vector<ExecutionPlan>& plans, std::vector<ScenarioResult>* results) const override;
+
+    // Runs every scenario of `plan`, which must have no problems. Results
+    // are indexed like plan.scenarios().
+    std::vector<ScenarioResult> runPlan(const ExecutionPlan& plan) const;
+
+    // Like runPlan, for several plans scheduled together; results are in
+    // plan order, then scenario order. Fills `stats` if given.
+    std::vector<ScenarioResult> schedule(const std::vector<const ExecutionPlan*>& plans,
+                                         WorkStealingScheduler::Stats* stats = nullptr) const;
+
+    // Runs one scenario with its Before and After hooks and returns how it
+    // went; nothing it throws escapes.
+    static ScenarioResult runScenario(const ExecutionPlan& plan,
+                                      const ExecutionPlan::Scenario& scenario,
+                                      types::ContextLifetime lifetime);
+
+private:
+    size_t m_threads;
+    types::ContextLifetime m_lifetime;
+};
+
+} // namespace pep
@@ -0,0 +1,444 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "ProcessPoolTestRunner.h"
+
+#include "ParallelTestRunner.h"
+#include "pepino/hooks/HookRegistry.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace pep
+{
+
+namespace
+{
+constexpr uint32_t NoTask = UINT32_MAX;
+
+struct Task
+{
+    const ExecutionPlan* plan;
+    const ExecutionPlan::Scenario* scenario;
+};
+
+// What a worker sends back after each scenario, followed by the message.
+// Both ends are the same binary, so the layout needs no encoding.
+struct ResultHeader
+{
+    uint8_t status;
+    int64_t nanoseconds;
+    uint32_t messageSize;
+};
+
+bool sendAll(int fd, const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        // MSG_NOSIGNAL: a dead peer is an error here, not a SIGPIPE.
+        const ssize_t sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// False at end of file, as when the other side is gone.
+bool receiveAll(int fd, void* data, size_t size)
+{
+    char* bytes = static_cast<char*>(data);
+    while (size > 0)
+    {
+        const ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool receiveResult(int fd, ScenarioResult& result)
+{
+    ResultHeader header;
+    if (!receiveAll(fd, &header, sizeof header))
+        return false;
+    result.status = static_cast<ScenarioResult::Status>(header.status);
+    result.duration = std::chrono::nanoseconds(header.nanoseconds);
+    result.message.resize(header.messageSize);
+    return receiveAll(fd, result.message.data(), header.messageSize);
+}
+
+void setLimit(int resource, rlim_t soft, rlim_t hard)
+{
+    const rlimit limit{ soft, hard };
+    ::setrlimit(resource, &limit);
+}
+
+// Gives the next scenario `seconds` of CPU time from now. The limit counts
+// the worker's whole life, so it is moved up by what earlier scenarios used;
+// a scenario that goes over it gets SIGXCPU. Only the soft limit moves, as an
+// unprivileged process cannot raise a hard limit it has lowered.
+void limitCpu(unsigned seconds)
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    const auto used = static_cast<rlim_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + 1;
+    rlimit limit{};
+    ::getrlimit(RLIMIT_CPU, &limit);
+    limit.rlim_cur = used + seconds;
+    if (limit.rlim_max != RLIM_INFINITY && limit.rlim_cur > limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+    }
+    ::setrlimit(RLIMIT_CPU, &limit);
+}
+
+// Runs the scenarios the parent sends until it closes the socket.
+[[noreturn]] void workerMain(int fd, const std::vector<Task>& tasks, types::ContextLifetime lifetime, WorkerLimits limits)
+{
+    // A crash is reported by the parent; a core file per crash helps nobody.
+    setLimit(RLIMIT_CORE, 0, 0);
+    if (limits.memoryBytes != 0)
+    {
+        setLimit(RLIMIT_AS, limits.memoryBytes, limits.memoryBytes);
+    }
+
+    int code = 0;
+    uint32_t index;
+    while (receiveAll(fd, &index, sizeof index))
+    {
+        if (limits.cpuSeconds != 0)
+        {
+            limitCpu(limits.cpuSeconds);
+        }
+        const auto& task = tasks[index];
+        const auto result = ParallelTestRunner::runScenario(*task.plan, *task.scenario, lifetime);
+        const ResultHeader header{ static_cast<uint8_t>(result.status),
+                                   static_cast<int64_t>(result.duration.count()),
+                                   static_cast<uint32_t>(result.message.size()) };
+        if (!sendAll(fd, &header, sizeof header) || !sendAll(fd, result.message.data(), result.message.size()))
+        {
+            code = 1;
+            break;
+        }
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    // Skip static destructors and atexit handlers; they belong to the parent.
+    ::_exit(code);
+}
+
+std::string describeExit(int status)
+{
+    if (WIFSIGNALED(status))
+    {
+        const int signal = WTERMSIG(status);
+        return "worker crashed with signal " + std::to_string(signal) + " (" + ::strsignal(signal) + ")";
+    }
+    if (WIFEXITED(status))
+    {
+        return "worker exited with code " + std::to_string(WEXITSTATUS(status));
+    }
+    return "worker stopped";
+}
+
+// The parent's end of every worker. Workers still running when the pool goes
+// away, which only happens on an error, are killed.
+class WorkerPool
+{
+public:
+    struct Worker
+    {
+        pid_t pid = -1;
+        int fd = -1;
+        uint32_t task = NoTask;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    WorkerPool(size_t count, const std::vector<Task>& tasks, types::ContextLifetime lifetime, WorkerLimits limits)
+        : m_workers(count), m_tasks(tasks), m_lifetime(lifetime), m_limits(limits)
+    {
+    }
+
+    ~WorkerPool()
+    {
+        for (auto& worker : m_workers)
+        {
+            if (worker.pid > 0 && worker.task != NoTask)
+            {
+                ::kill(worker.pid, SIGKILL);
+            }
+            stop(worker);
+        }
+    }
+
+    std::vector<Worker>& workers() { return m_workers; }
+
+    void spawn(Worker& worker)
+    {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        {
+            throw std::runtime_error(std::string("Cannot create a worker socket: ") + std::strerror(errno));
+        }
+        const pid_t pid = ::fork();
+        if (pid < 0)
+        {
+            ::close(fds[0]);
+            ::close(fds[1]);
+            throw std::runtime_error(std::string("Cannot fork a worker: ") + std::strerror(errno));
+        }
+        if (pid == 0)
+        {
+            ::close(fds[0]);
+            for (const auto& other : m_workers)
+            {
+                if (other.fd >= 0)
+                    ::close(other.fd);
+            }
+            workerMain(fds[1], m_tasks, m_lifetime, m_limits);
+        }
+        ::close(fds[1]);
+        worker.pid = pid;
+        worker.fd = fds[0];
+        worker.task = NoTask;
+    }
+
+    // Closes the worker's socket, which ends it once it is idle, and reaps
+    // it. Returns its wait status.
+    int stop(Worker& worker)
+    {
+        if (worker.fd >= 0)
+        {
+            ::close(worker.fd);
+            worker.fd = -1;
+        }
+        int status = 0;
+        if (worker.pid > 0)
+        {
+            while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+            worker.pid = -1;
+        }
+        return status;
+    }
+
+private:
+    std::vector<Worker> m_workers;
+    const std::vector<Task>& m_tasks;
+    types::ContextLifetime m_lifetime;
+    WorkerLimits m_limits;
+};
+} // namespace
+
+ProcessPoolTestRunner::ProcessPoolTestRunner(size_t workers, types::ContextLifetime lifetime, WorkerLimits limits)
+    : m_workers(workers), m_lifetime(lifetime), m_limits(limits)
+{
+}
+
+int ProcessPoolTestRunner::runPlans(const std::vector<ExecutionPlan>& plans, std::vector<ScenarioResult>* results) const
+{
+    if (const size_t problems = ExecutionPlan::logProblems(plans); problems > 0)
+    {
+        std::cerr << "Test failed: " << problems << " step(s) cannot run" << std::endl;
+        return 42; // failure (test failed)
+    }
+
+    try
+    {
+        std::vector<const ExecutionPlan*> pointers;
+        for (const auto& plan : plans)
+        {
+            pointers.push_back(&plan);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        auto scenarioResults = schedule(pointers);
+        const std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - start;
+
+        // The result is that of the first scenario that did not pass.
+        int ret = 0;
+        size_t next = 0;
+        size_t crashed = 0;
+        for (const auto& plan : plans)
+        {
+            for (const auto& scenario : plan.scenarios())
+            {
+                const auto& result = scenarioResults[next++];
+                std::cout << scenario.banner << std::endl;
+                if (result.status != ScenarioResult::Status::Passed)
+                {
+                    std::cerr << "Test failed: " << result.message << std::endl;
+                    if (ret == 0)
+                    {
+                        ret = result.exitCode();
+                    }
+                }
+                if (result.status == ScenarioResult::Status::Crashed)
+                {
+                    ++crashed;
+                }
+            }
+        }
+        std::ostringstream summary;
+        summary << "Ran " << scenarioResults.size() << " scenarios in worker processes in " << std::fixed
+                << std::setprecision(1) << wall.count() << " ms; " << crashed << " crashed";
+        std::cout << summary.str() << std::endl;
+        if (results)
+        {
+            std::move(scenarioResults.begin(), scenarioResults.end(), std::back_inserter(*results));
+        }
+        return ret;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Caught exception: " << e.what() << std::endl;
+        return 2; // failure (exception caught)
+    }
+}
+
+std::vector<ScenarioResult> ProcessPoolTestRunner::schedule(const std::vector<const ExecutionPlan*>& plans) const
+{
+    std::vector<Task> tasks;
+    for (const ExecutionPlan* plan : plans)
+    {
+        for (const auto& scenario : plan->scenarios())
+        {
+            tasks.push_back({ plan, &scenario });
+        }
+    }
+    std::vector<ScenarioResult> results(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        results[i].id = tasks[i].scenario->id;
+    }
+
+    for (const ExecutionPlan* plan : plans)
+    {
+        HookRegistry::getInstance().executeBeforeAll(plan->feature());
+    }
+    // Anything still buffered would otherwise be written again by every worker.
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    if (!tasks.empty())
+    {
+        const size_t workers = m_workers != 0 ? m_workers : std::max(1u, std::thread::hardware_concurrency());
+        WorkerPool pool(std::min(workers, tasks.size()), tasks, m_lifetime, m_limits);
+
+        // Workers take one scenario at a time, so a slow one holds up no
+        // other; the next one goes to whichever worker reports back first.
+        size_t next = 0;
+        const auto dispatch = [&](WorkerPool::Worker& worker)
+        {
+            if (next == tasks.size())
+            {
+                pool.stop(worker);
+                return;
+            }
+            worker.task = static_cast<uint32_t>(next++);
+            worker.started = std::chrono::steady_clock::now();
+            // If the worker is already gone, reading its result finds out.
+            sendAll(worker.fd, &worker.task, sizeof worker.task);
+        };
+        for (auto& worker : pool.workers())
+        {
+            pool.spawn(worker);
+            dispatch(worker);
+        }
+
+        size_t done = 0;
+        std::vector<pollfd> fds;
+        while (done < tasks.size())
+        {
+            fds.clear();
+            for (const auto& worker : pool.workers())
+            {
+                // Negative descriptors, of stopped workers, are ignored.
+                fds.push_back({ worker.fd, POLLIN, 0 });
+            }
+            if (::poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error(std::string("Cannot wait for workers: ") + std::strerror(errno));
+            }
+            for (size_t i = 0; i < fds.size(); ++i)
+            {
+                if (fds[i].fd < 0 || fds[i].revents == 0)
+                    continue;
+                auto& worker = pool.workers()[i];
+                auto& result = results[worker.task];
+                ++done;
+                if (receiveResult(worker.fd, result))
+                {
+                    worker.task = NoTask;
+                    dispatch(worker);
+                    continue;
+                }
+
+                // The worker died before reporting; replace it.
+                const auto duration = std::chrono::steady_clock::now() - worker.started;
+                const auto& scenario = *tasks[worker.task].scenario;
+                worker.task = NoTask;
+                result.status = ScenarioResult::Status::Crashed;
+                result.message = scenario.info.name + ": " + describeExit(pool.stop(worker));
+                result.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(duration);
+                if (next < tasks.size())
+                {
+                    pool.spawn(worker);
+                    dispatch(worker);
+                }
+            }
+        }
+    }
+
+    for (const ExecutionPlan* plan : plans)
+    {
+        HookRegistry::getInstance().executeAfterAll(plan->feature());
+    }
+    return results;
+}
+
+} // namespace pep
@@ -0,0 +1,66 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "ExecutionPlan.h"
+#include "ITestRunner.h"
+#include "ScenarioResult.h"
+#include "pepino/types/types.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace pep
+{
+
+// Resource limits applied to every worker process; 0 means no limit.
+struct WorkerLimits
+{
+    size_t memoryBytes = 0; // Address space (RLIMIT_AS)
+    unsigned cpuSeconds = 0; // CPU time per scenario, at least this and under a second more (RLIMIT_CPU)
+};
+
+// ProcessPoolTestRunner runs scenarios in a pool of forked worker processes,
+// so a step that crashes takes down one worker rather than the run. Workers
+// are forked once, after the plans are compiled and the BeforeAll hooks have
+// run, and inherit both; the parent then hands them scenarios one at a time
+// over a socket and reads back each result. A worker that dies is reported
+// as a Crashed result for the scenario it was running, with the signal, and
+// is replaced while scenarios remain. Before and After hooks run in the
+// workers, BeforeAll and AfterAll hooks in the parent, so state changed by a
+// scenario is not seen by AfterAll. Results are reported in plan order, as
+// with ParallelTestRunner.
+class ProcessPoolTestRunner : public ITestRunner
+{
+public:
+    // 0 workers means one per hardware thread.
+    explicit ProcessPoolTestRunner(size_t workers = 0,
+                                   types::ContextLifetime lifetime = types::ContextLifetime::Scenario,
+                                   WorkerLimits limits = {});
+
+    int runPlans(const std::vector<ExecutionPlan>& plans, std::vector<ScenarioResult>* results) const override;
+
+    // Runs every scenario of the plans, which must have no problems. Results
+    // are in plan order, then scenario order.
+    std::vector<ScenarioResult> schedule(const std::vector<const ExecutionPlan*>& plans) const;
+
+private:
+    size_t m_workers;
+    types::ContextLifetime m_lifetime;
+    WorkerLimits m_limits;
+};
+
+} // namespace pep
@@ -0,0 +1,270 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "ResultFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace pep
+{
+
+namespace
+{
+constexpr const char* Magic = "pepino-results";
+constexpr int Version = 1;
+
+std::string escape(const std::string& text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string unescape(const std::string& text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] != '\\' || i + 1 == text.size())
+        {
+            out += text[i];
+            continue;
+        }
+        const char c = text[++i];
+        out += c == 't' ? '\t' : c == 'n' ? '\n' : c;
+    }
+    return out;
+}
+
+std::vector<std::string> split(const std::string& line)
+{
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (size_t tab; (tab = line.find('\t', start)) != std::string::npos; start = tab + 1)
+    {
+        fields.push_back(line.substr(start, tab - start));
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+const char* statusName(ScenarioResult::Status status)
+{
+    switch (status)
+    {
+    case ScenarioResult::Status::Passed:
+        return "passed";
+    case ScenarioResult::Status::Failed:
+        return "failed";
+    case ScenarioResult::Status::Crashed:
+        return "crashed";
+    default:
+        return "error";
+    }
+}
+
+ScenarioResult::Status parseStatus(const std::string& name)
+{
+    if (name == "passed")
+        return ScenarioResult::Status::Passed;
+    if (name == "failed")
+        return ScenarioResult::Status::Failed;
+    if (name == "error")
+        return ScenarioResult::Status::Error;
+    if (name == "crashed")
+        return ScenarioResult::Status::Crashed;
+    throw std::runtime_error("Unknown scenario status: " + name);
+}
+} // namespace
+
+void ResultFile::write(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error("Cannot write result file: " + path);
+    }
+    out << Magic << '\t' << Version << '\n';
+    out << "shard\t" << shardIndex << '\t' << shardCount << '\n';
+    out << "exit\t" << exitCode << '\n';
+    for (const auto& result : results)
+    {
+        out << "scenario\t" << statusName(result.status) << '\t' << result.duration.count() << '\t'
+            << escape(result.id) << '\t' << escape(result.message) << '\n';
+    }
+    for (const auto& problem : problems)
+    {
+        out << "problem\t" << problem.scenarios << '\t' << escape(problem.id) << '\t' << escape(problem.step) << '\t'
+            << escape(problem.message) << '\n';
+    }
+    if (!out.flush())
+    {
+        throw std::runtime_error("Cannot write result file: " + path);
+    }
+}
+
+ResultFile ResultFile::read(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        throw std::runtime_error("Cannot read result file: " + path);
+    }
+
+    ResultFile file;
+    std::string line;
+    if (!std::getline(in, line) || line != Magic + std::string("\t") + std::to_string(Version))
+    {
+        throw std::runtime_error("Not a pepino result file: " + path);
+    }
+    size_t number = 1;
+    while (std::getline(in, line))
+    {
+        ++number;
+        if (line.empty())
+            continue;
+        const auto fields = split(line);
+        try
+        {
+            if (fields[0] == "shard" && fields.size() == 3)
+            {
+                file.shardIndex = static_cast<unsigned>(std::stoul(fields[1]));
+                file.shardCount = static_cast<unsigned>(std::stoul(fields[2]));
+            }
+            else if (fields[0] == "exit" && fields.size() == 2)
+            {
+                file.exitCode = std::stoi(fields[1]);
+            }
+            else if (fields[0] == "scenario" && fields.size() == 5)
+            {
+                ScenarioResult result;
+                result.status = parseStatus(fields[1]);
+                result.duration = std::chrono::nanoseconds(std::stoll(fields[2]));
+                result.id = unescape(fields[3]);
+                result.message = unescape(fields[4]);
+                file.results.push_back(std::move(result));
+            }
+            else if (fields[0] == "problem" && fields.size() == 5)
+            {
+                file.problems.push_back(
+                    { std::stoul(fields[1]), unescape(fields[2]), unescape(fields[3]), unescape(fields[4]) });
+            }
+            else
+            {
+                throw std::runtime_error("unexpected record");
+            }
+        }
+        catch (const std::exception& e)
+        {
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": " + e.what());
+        }
+    }
+    return file;
+}
+
+std::unordered_map<std::string, std::chrono::nanoseconds> ResultFile::durations() const
+{
+    std::unordered_map<std::string, std::chrono::nanoseconds> durations;
+    for (const auto& result : results)
+    {
+        durations[result.id] = result.duration;
+    }
+    return durations;
+}
+
+ResultFile ResultFile::merge(const std::vector<ResultFile>& shards)
+{
+    if (shards.empty())
+    {
+        throw std::runtime_error("No result files to merge");
+    }
+
+    std::vector<const ResultFile*> ordered;
+    for (const auto& shard : shards)
+    {
+        if (shard.shardCount != shards.front().shardCount)
+        {
+            throw std::runtime_error("Result files come from runs with different shard counts");
+        }
+        ordered.push_back(&shard);
+    }
+    std::sort(ordered.begin(),
+              ordered.end(),
+              [](const ResultFile* a, const ResultFile* b) { return a->shardIndex < b->shardIndex; });
+    for (unsigned i = 0; i < ordered.size(); ++i)
+    {
+        if (ordered[i]->shardIndex != i)
+        {
+            throw std::runtime_error("Missing or repeated shard " + std::to_string(i) + " of " +
+                                     std::to_string(shards.front().shardCount));
+        }
+    }
+    if (ordered.size() != shards.front().shardCount)
+    {
+        throw std::runtime_error("Expected " + std::to_string(shards.front().shardCount) + " result files, got " +
+                                 std::to_string(ordered.size()));
+    }
+
+    ResultFile merged;
+    std::set<std::string> seen;
+    for (const auto* shard : ordered)
+    {
+        if (merged.exitCode == 0)
+        {
+            merged.exitCode = shard->exitCode;
+        }
+        for (const auto& result : shard->results)
+        {
+            if (!seen.insert(result.id).second)
+            {
+                throw std::runtime_error("Scenario reported by more than one shard: " + result.id);
+            }
+            merged.results.push_back(result);
+        }
+        for (const auto& problem : shard->problems)
+        {
+            merged.problems.push_back(problem);
+        }
+    }
+    std::sort(merged.results.begin(),
+              merged.results.end(),
+              [](const ScenarioResult& a, const ScenarioResult& b) { return a.id < b.id; });
+    return merged;
+}
+
+} // namespace pep
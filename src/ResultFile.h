@@ -0,0 +1,72 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "ScenarioResult.h"
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pep
+{
+
+// The results of one run, or of one shard of it, as a text file that other
+// tools can read: a version line, then tab-separated records.
+//
+//   pepino-results	1
+//   shard	<index>	<count>
+//   exit	<code>
+//   scenario	<passed|failed|error|crashed>	<nanoseconds>	<id>	<message>
+//   problem	<scenarios>	<first id>	<step>	<message>
+//
+// A problem is a step that kept scenarios from running at all, such as an
+// undefined one; its record names the first of the scenarios and counts them.
+//
+// Tabs, newlines and backslashes inside fields are escaped as \t, \n and \\.
+struct ResultFile
+{
+    struct Problem
+    {
+        size_t scenarios = 0;
+        std::string id;
+        std::string step; // Empty if the problem is not one step's
+        std::string message;
+    };
+
+    unsigned shardIndex = 0;
+    unsigned shardCount = 1;
+    int exitCode = 0;
+    std::vector<ScenarioResult> results;
+    std::vector<Problem> problems;
+
+    void write(const std::string& path) const;
+    // Throws std::runtime_error if the file is missing or malformed.
+    static ResultFile read(const std::string& path);
+
+    // Scenario durations by id, for weighting shards.
+    std::unordered_map<std::string, std::chrono::nanoseconds> durations() const;
+
+    // Combines the files of every shard of one run into one result, with the
+    // problems of all shards and the exit code of the first failing one.
+    // Throws std::runtime_error unless each shard of the run is given exactly
+    // once.
+    static ResultFile merge(const std::vector<ResultFile>& shards);
+};
+
+} // namespace pep
@@ -0,0 +1,55 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace pep
+{
+
+// The outcome of one scenario of an execution plan.
+struct ScenarioResult
+{
+    enum class Status
+    {
+        Passed,
+        Failed, // A step threw pep::TestFailure
+        Error,  // A step or hook threw anything else
+        Crashed // The worker process running it died
+    };
+
+    std::string id; // The scenario's ExecutionPlan::Scenario::id
+    Status status = Status::Passed;
+    std::string message; // Why it did not pass
+    std::chrono::nanoseconds duration{ 0 };
+
+    // The code a runner returns for this outcome.
+    int exitCode() const
+    {
+        switch (status)
+        {
+        case Status::Passed:
+            return 0;
+        case Status::Failed:
+            return 42;
+        default:
+            return 2;
+        }
+    }
+};
+
+} // namespace pep
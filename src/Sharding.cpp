@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "Sharding.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace pep
+{
+
+uint64_t stableHash(std::string_view text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : text)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void selectShard(std::vector<ExecutionPlan>& plans,
+                 Shard shard,
+                 const std::unordered_map<std::string, std::chrono::nanoseconds>& durations)
+{
+    if (shard.count == 0 || shard.index >= shard.count)
+    {
+        throw std::invalid_argument("Shard " + std::to_string(shard.index) + " of " + std::to_string(shard.count) +
+                                    " does not exist");
+    }
+
+    struct Entry
+    {
+        const std::string* id;
+        uint64_t hash;
+        std::chrono::nanoseconds weight;
+    };
+    std::vector<Entry> entries;
+    std::chrono::nanoseconds known{ 0 };
+    size_t knownCount = 0;
+    for (const auto& plan : plans)
+    {
+        for (const auto& scenario : plan.scenarios())
+        {
+            auto weight = std::chrono::nanoseconds(-1);
+            if (auto it = durations.find(scenario.id); it != durations.end())
+            {
+                weight = it->second;
+                known += weight;
+                ++knownCount;
+            }
+            entries.push_back({ &scenario.id, stableHash(scenario.id), weight });
+        }
+    }
+
+    // Ids dealt by duration, and whether they are this shard's. The rest,
+    // including those of problems that have no scenario, go by their hash.
+    std::unordered_map<std::string, bool> dealt;
+    if (knownCount > 0)
+    {
+        // Longest processing time first: every shard runs this same greedy
+        // deal, ties broken by hash and then id, and keeps its part.
+        const auto average = known / knownCount;
+        for (auto& entry : entries)
+        {
+            if (entry.weight.count() < 0)
+            {
+                entry.weight = average;
+            }
+        }
+        std::sort(entries.begin(),
+                  entries.end(),
+                  [](const Entry& a, const Entry& b)
+                  {
+                      if (a.weight != b.weight)
+                          return a.weight > b.weight;
+                      if (a.hash != b.hash)
+                          return a.hash < b.hash;
+                      return *a.id < *b.id;
+                  });
+        std::vector<std::chrono::nanoseconds> load(shard.count, std::chrono::nanoseconds{ 0 });
+        for (const auto& entry : entries)
+        {
+            const auto lightest = static_cast<unsigned>(std::min_element(load.begin(), load.end()) - load.begin());
+            load[lightest] += entry.weight;
+            dealt.emplace(*entry.id, lightest == shard.index);
+        }
+    }
+
+    const auto mine = [&](const std::string& id)
+    {
+        if (auto it = dealt.find(id); it != dealt.end())
+            return it->second;
+        return stableHash(id) % shard.count == shard.index;
+    };
+    for (auto& plan : plans)
+    {
+        plan.retain(mine);
+    }
+}
+
+} // namespace pep
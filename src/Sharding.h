@@ -0,0 +1,52 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "ExecutionPlan.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pep
+{
+
+// One of `count` parts of a suite. Every shard sees the same feature files,
+// expands them the same way and keeps its own part, so shards agree on the
+// split without talking to each other.
+struct Shard
+{
+    unsigned index = 0;
+    unsigned count = 1;
+};
+
+// FNV-1a; unlike std::hash it is the same on every platform and build.
+uint64_t stableHash(std::string_view text);
+
+// Keeps only the scenarios of `plans` that belong to `shard`, and the
+// problems of those scenarios, so a broken step fails only its shard. Without
+// durations a scenario's shard follows from the hash of its id alone. With
+// durations by id (from earlier result files), scenarios are dealt longest
+// first to the shard with the least work so far; those without a recorded
+// duration count as the average one.
+void selectShard(std::vector<ExecutionPlan>& plans,
+                 Shard shard,
+                 const std::unordered_map<std::string, std::chrono::nanoseconds>& durations = {});
+
+} // namespace pep
@@ -0,0 +1,412 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "pepino/steps/StepRegistry.h"
+
+#include "matching/Automaton.h"
+#include "matching/CucumberExpression.h"
+#include "matching/StepIndex.h"
+#include "matching/StepMatcher.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <mutex>
+
+namespace pep
+{
+
+StepRegistry::StepRegistry()
+{
+    for (auto& index : m_indexes)
+        index = std::make_unique<matching::StepIndex>();
+}
+
+StepRegistry::~StepRegistry() = default;
+
+namespace
+{
+// Patterns compiled at build time keep their program whatever the backend,
+// and Cucumber Expressions use no regex backend at all.
+std::shared_ptr<const matching::IStepMatcher> makeMatcher(const std::string& pattern,
+                                                          const matching::ProgramView* program,
+                                                          types::RegexBackend backend)
+{
+    if (program)
+        return matching::makeProgramMatcher(*program);
+    if (matching::isCucumberExpression(pattern))
+        return matching::makeExpressionMatcher(pattern);
+    return matching::makeMatcher(pattern, backend);
+}
+} // namespace
+
+void StepRegistry::addStep(StepDefinitionPtr step)
+{
+    step->matcher = makeMatcher(step->patternStr, step->program, m_backend);
+    matching::PatternShape shape;
+    if (matching::isCucumberExpression(step->patternStr))
+    {
+        step->specificity = matching::expressionSpecificity(step->patternStr);
+        shape = matching::analyzeExpression(step->patternStr);
+    }
+    else
+    {
+        step->specificity = computeSpecificity(step->patternStr);
+        shape = matching::analyzePattern(step->patternStr);
+    }
+    for (size_t partition = 0; partition < m_indexes.size(); ++partition)
+    {
+        if (inPartition(step->type, partition))
+            m_indexes[partition]->add(static_cast<uint32_t>(steps.size()), shape);
+    }
+    steps.push_back(std::move(step));
+    if (m_automaton)
+        addToAutomaton(static_cast<uint32_t>(steps.size() - 1));
+    // A new definition may change what any step text resolves to.
+    clearResolutionCache();
+}
+
+void StepRegistry::setMatchStrategy(types::MatchStrategy strategy)
+{
+    m_strategy = strategy;
+    m_automaton.reset();
+    m_unsupported.clear();
+    if (strategy == types::MatchStrategy::Automaton)
+    {
+        m_automaton = std::make_unique<matching::Automaton>();
+        for (uint32_t id = 0; id < steps.size(); ++id)
+            addToAutomaton(id);
+    }
+    clearResolutionCache();
+}
+
+void StepRegistry::setRegexBackend(types::RegexBackend backend)
+{
+    m_backend = backend;
+    for (const auto& step : steps)
+        step->matcher = makeMatcher(step->patternStr, step->program, backend);
+    clearResolutionCache();
+}
+
+void StepRegistry::setStrictKeywords(bool strict)
+{
+    m_strict = strict;
+    clearResolutionCache();
+}
+
+size_t StepRegistry::partitionOf(types::StepType keyword) const
+{
+    if (!m_strict)
+        return AnyKeyword;
+    switch (keyword)
+    {
+    case types::StepType::Given:
+        return 0;
+    case types::StepType::When:
+        return 1;
+    case types::StepType::Then:
+        return 2;
+    default:
+        // And/But with nothing before them to inherit from
+        return AnyKeyword;
+    }
+}
+
+// Definitions registered with AND or BUT fit every keyword.
+bool StepRegistry::inPartition(types::StepType type, size_t partition)
+{
+    switch (type)
+    {
+    case types::StepType::Given:
+        return partition == 0 || partition == AnyKeyword;
+    case types::StepType::When:
+        return partition == 1 || partition == AnyKeyword;
+    case types::StepType::Then:
+        return partition == 2 || partition == AnyKeyword;
+    default:
+        return true;
+    }
+}
+
+void StepRegistry::defineParameterType(std::string name, std::function<bool(std::string_view)> accepts)
+{
+    matching::defineParameterType(std::move(name), std::move(accepts));
+    // Steps using the type may resolve differently now.
+    clearResolutionCache();
+}
+
+void StepRegistry::addToAutomaton(uint32_t id)
+{
+    if (matching::isCucumberExpression(steps[id]->patternStr) || !m_automaton->add(id, steps[id]->patternStr))
+        m_unsupported.push_back(id);
+}
+
+void StepRegistry::executeStep(std::string_view stepText) const
+{
+    run(*resolve(stepText, AnyKeyword), stepText);
+}
+
+void StepRegistry::executeStep(types::StepType keyword, std::string_view stepText) const
+{
+    run(*resolve(stepText, partitionOf(keyword)), stepText);
+}
+
+void StepRegistry::run(const Resolution& resolution, std::string_view stepText) const
+{
+    if (!resolution.definition)
+    {
+        throw std::runtime_error("No matching step found for: (START)" + std::string(stepText) + "(END)");
+    }
+    const auto& best = resolution.definition;
+
+    std::cout << "Executing step with regex: " << best->patternStr << std::endl;
+
+    // Captures view the step text; nothing is copied on the way to the callback.
+    CaptureList captures;
+    for (const auto& [offset, length] : resolution.captures)
+        captures.push_back(stepText.substr(offset, length));
+
+    try
+    {
+        best->func(captures);
+    }
+    catch (StepArgumentException& e)
+    {
+        e.setStep(stepText);
+        throw;
+    }
+}
+
+StepRegistry::BoundStep StepRegistry::bindStep(types::StepType keyword, std::string_view stepText) const
+{
+    BoundStep bound;
+    const size_t partition = partitionOf(keyword);
+    const ResolutionPtr resolution = resolve(stepText, partition);
+    const auto& best = resolution->definition;
+    if (!best)
+    {
+        return bound;
+    }
+    bound.pattern = best->patternStr;
+
+    // A definition ranked as high that matches too only loses on registration
+    // order, which is rarely what the author meant.
+    std::vector<matching::StepIndex::Candidate> candidates;
+    m_indexes[partition]->collect(stepText, candidates);
+    for (const auto& candidate : candidates)
+    {
+        const auto& other = steps[candidate.id];
+        if (other == best || other->specificity != best->specificity)
+            continue;
+        if (candidate.exact || other->matcher->match(stepText, nullptr))
+            bound.ambiguousWith.push_back(other->patternStr);
+    }
+
+    CaptureList captures;
+    for (const auto& [offset, length] : resolution->captures)
+        captures.push_back(stepText.substr(offset, length));
+    try
+    {
+        bound.call = best->prepare(captures);
+    }
+    catch (StepArgumentException& e)
+    {
+        e.setStep(stepText);
+        throw;
+    }
+    return bound;
+}
+
+StepRegistry::ResolutionPtr StepRegistry::resolve(std::string_view stepText, size_t partition) const
+{
+    auto& resolutions = m_resolutions[partition];
+    {
+        std::shared_lock lock(m_cacheMutex);
+        if (auto it = resolutions.find(stepText); it != resolutions.end())
+        {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+
+    // Match outside the lock; if two threads race on the same text they
+    // compute the same resolution.
+    ResolutionPtr resolution = match(stepText, partition);
+
+    std::unique_lock lock(m_cacheMutex);
+    if (resolutions.size() >= MaxCachedResolutions)
+    {
+        resolutions.clear();
+    }
+    resolutions.try_emplace(std::string(stepText), resolution);
+    return resolution;
+}
+
+StepRegistry::ResolutionPtr StepRegistry::match(std::string_view stepText, size_t partition) const
+{
+    std::vector<Candidate> candidates;
+    switch (m_strategy)
+    {
+    case types::MatchStrategy::Linear:
+        return matchLinear(stepText, partition);
+    case types::MatchStrategy::Tiered:
+    {
+        std::vector<matching::StepIndex::Candidate> indexed;
+        m_indexes[partition]->collect(stepText, indexed);
+        for (const auto& candidate : indexed)
+            candidates.push_back({ candidate.id, candidate.exact });
+        break;
+    }
+    case types::MatchStrategy::Automaton:
+    {
+        std::vector<uint32_t> matched;
+        m_automaton->matchAll(stepText, matched);
+        for (uint32_t id : matched)
+        {
+            if (inPartition(steps[id]->type, partition))
+                candidates.push_back({ id, true });
+        }
+        for (uint32_t id : m_unsupported)
+        {
+            if (inPartition(steps[id]->type, partition))
+                candidates.push_back({ id, false });
+        }
+        break;
+    }
+    }
+    return pickBest(stepText, candidates);
+}
+
+StepRegistry::ResolutionPtr StepRegistry::pickBest(std::string_view stepText, std::vector<Candidate>& candidates) const
+{
+    // Choose the highest specificity; the earliest registration wins ties.
+    // Trying candidates in that order means the first match is the winner.
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [this](const auto& a, const auto& b)
+              {
+                  const int sa = steps[a.id]->specificity;
+                  const int sb = steps[b.id]->specificity;
+                  return sa != sb ? sa > sb : a.id < b.id;
+              });
+
+    auto resolution = std::make_shared<Resolution>();
+    for (const auto& candidate : candidates)
+    {
+        const auto& sd = steps[candidate.id];
+        if (candidate.matches && sd->matcher->groups() == 0)
+        {
+            // Nothing to capture, so the pattern need not run at all.
+            resolution->definition = sd;
+            break;
+        }
+        if (sd->matcher->match(stepText, &resolution->captures))
+        {
+            resolution->definition = sd;
+            break;
+        }
+    }
+    return resolution;
+}
+
+StepRegistry::ResolutionPtr StepRegistry::matchLinear(std::string_view stepText, size_t partition) const
+{
+    auto resolution = std::make_shared<Resolution>();
+    matching::CaptureSpans captures;
+    for (const auto& sd : steps)
+    {
+        if (!inPartition(sd->type, partition))
+            continue;
+        if (resolution->definition && sd->specificity <= resolution->definition->specificity)
+            continue;
+        if (sd->matcher->match(stepText, &captures))
+        {
+            resolution->definition = sd;
+            resolution->captures = captures;
+        }
+    }
+    return resolution;
+}
+
+StepRegistry::CacheStats StepRegistry::cacheStats() const
+{
+    std::shared_lock lock(m_cacheMutex);
+    size_t entries = 0;
+    for (const auto& resolutions : m_resolutions)
+        entries += resolutions.size();
+    return { m_hits.load(std::memory_order_relaxed), m_misses.load(std::memory_order_relaxed), entries };
+}
+
+void StepRegistry::clearResolutionCache()
+{
+    std::unique_lock lock(m_cacheMutex);
+    for (auto& resolutions : m_resolutions)
+        resolutions.clear();
+    m_hits = 0;
+    m_misses = 0;
+}
+
+// Heuristic: count literals and tokens to rank specificity
+int StepRegistry::computeSpecificity(const std::string& pat)
+{
+    int score = 0;
+    size_t pos = 0;
+    while (pos < pat.size())
+    {
+        if (pat.compare(pos, 2, "\\d") == 0)
+        {
+            score += 2;
+            pos += 2;
+        }
+        else if (pat.compare(pos, 2, "\\w") == 0)
+        {
+            score += 1;
+            pos += 2;
+        }
+        else if (pat[pos] == '^' || pat[pos] == '$')
+        {
+            score += 3;
+            pos += 1;
+        }
+        else if (pat[pos] == '[')
+        {
+            auto end = pat.find(']', pos);
+            if (end != std::string::npos)
+            {
+                int len = static_cast<int>(end - pos - 1);
+                score += (len > 0 ? len : 1);
+                pos = end + 1;
+            }
+            else
+            {
+                pos++;
+            }
+        }
+        else if (std::isalnum(static_cast<unsigned char>(pat[pos])))
+        {
+            score += 4;
+            pos++;
+        }
+        else
+        {
+            pos++;
+        }
+    }
+    return score;
+}
+
+} // namespace pep
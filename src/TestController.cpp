@@ -16,44 +16,242 @@
 
 #include "TestController.h"
 
+#include "Logger.h"
+#include "ResultFile.h"
+#include "Sharding.h"
+#include "parsing/FeatureCache.h"
 #include "parsing/Lexer.h"
 #include "parsing/Parser.h"
+#include "parsing/SourceFile.h"
 #include "parsing/Statement.h"
 
-#include <fstream>
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+
+#include <glob.h>
 
 namespace pep
 {
 
-TestController::TestController(std::unique_ptr<ITestRunner> runner)
-    : testRunner(std::move(runner))
+namespace
+{
+bool isGlobPattern(const std::string& input)
+{
+    return input.find_first_of("*?[") != std::string::npos;
+}
+
+// A feature file's path relative to the working directory, with forward
+// slashes, so scenario ids match across machines that check out the suite
+// in different places.
+std::string sourceId(const std::string& input)
+{
+    std::filesystem::path path(input);
+    if (path.is_absolute())
+    {
+        std::error_code error;
+        auto relative = path.lexically_relative(std::filesystem::current_path(error));
+        if (!error && !relative.empty())
+        {
+            path = relative;
+        }
+    }
+    return path.lexically_normal().generic_string();
+}
+} // namespace
+
+TestController::TestController(std::unique_ptr<ITestRunner> runner, RunOptions options)
+    : testRunner(std::move(runner)), m_options(std::move(options))
 {
 }
 
 int TestController::executeTest(const std::string& input)
 {
-    // Read the file content
-    std::ifstream file(input);
-    if (!file.is_open())
+    if (std::filesystem::is_directory(input) || (isGlobPattern(input) && !std::filesystem::exists(input)))
+    {
+        return executeTests(resolveInputs(input));
+    }
+
+    std::optional<FeatureCache> cache;
+    if (!m_options.cacheDirectory.empty())
+    {
+        cache.emplace(m_options.cacheDirectory);
+    }
+    std::vector<FlatFeature> features;
+    features.push_back(loadFeature(input, cache ? &*cache : nullptr));
+    return runFeatures(features, { input });
+}
+
+int TestController::executeTests(const std::vector<std::string>& inputs)
+{
+    if (inputs.empty())
+    {
+        throw std::runtime_error("No feature files to run");
+    }
+
+    std::optional<FeatureCache> cache;
+    if (!m_options.cacheDirectory.empty())
+    {
+        cache.emplace(m_options.cacheDirectory);
+    }
+
+    // Each file gets its own slot, so the results keep the input order no
+    // matter which thread finishes first.
+    std::vector<std::optional<FlatFeature>> features(inputs.size());
+    std::vector<std::string> errors(inputs.size());
+    {
+        const size_t threads = m_options.jobs != 0 ? m_options.jobs : std::max(1u, std::thread::hardware_concurrency());
+        ThreadPool pool(std::min(threads, inputs.size()));
+        pool.forEach(
+            inputs.size(),
+            [&](size_t i)
+            {
+                try
+                {
+                    features[i] = loadFeature(inputs[i], cache ? &*cache : nullptr);
+                }
+                catch (const std::exception& e)
+                {
+                    errors[i] = inputs[i] + ": " + e.what();
+                }
+            });
+    }
+
+    std::string report;
+    size_t failed = 0;
+    for (const auto& error : errors)
+    {
+        if (!error.empty())
+        {
+            Logger::error(error);
+            report += "\n  " + error;
+            ++failed;
+        }
+    }
+    if (failed > 0)
+    {
+        throw std::runtime_error("Failed to load " + std::to_string(failed) + " of " + std::to_string(inputs.size()) +
+                                 " feature files:" + report);
+    }
+
+    std::vector<FlatFeature> loaded;
+    loaded.reserve(features.size());
+    for (auto& feature : features)
+    {
+        loaded.push_back(std::move(*feature));
+    }
+    return runFeatures(loaded, inputs);
+}
+
+int TestController::runFeatures(const std::vector<FlatFeature>& features, const std::vector<std::string>& inputs) const
+{
+    const Shard shard{ m_options.shardIndex, m_options.shardCount };
+    if (shard.count == 0 || shard.index >= shard.count)
     {
-        throw std::runtime_error("Could not open file: " + input);
+        throw std::invalid_argument("Shard index " + std::to_string(shard.index) + " is not below the shard count " +
+                                    std::to_string(shard.count));
     }
 
-    std::string content((std::istreambuf_iterator<char>(file)),
-                        std::istreambuf_iterator<char>());
-    file.close();
-    // Tokenize the content
-    Lexer lexer(content);
-    std::vector<Token> tokens = lexer.tokenize();
-    // Parse the tokens into a feature statement
-    Parser parser(tokens);
+    std::vector<ExecutionPlan> plans;
+    plans.reserve(features.size());
+    for (size_t i = 0; i < features.size(); ++i)
+    {
+        plans.push_back(ExecutionPlan::compile(features[i], sourceId(inputs[i])));
+    }
+    if (shard.count > 1)
+    {
+        std::unordered_map<std::string, std::chrono::nanoseconds> durations;
+        if (!m_options.shardDurations.empty())
+        {
+            durations = ResultFile::read(m_options.shardDurations).durations();
+        }
+        selectShard(plans, shard, durations);
+    }
+
+    if (m_options.resultFile.empty())
+    {
+        return testRunner->runPlans(plans, nullptr);
+    }
+    ResultFile results;
+    results.shardIndex = shard.index;
+    results.shardCount = shard.count;
+    for (const auto& plan : plans)
+    {
+        for (const auto& problem : plan.problems())
+        {
+            results.problems.push_back({ problem.ids.size(), problem.ids.front(), problem.step, problem.message });
+        }
+    }
+    results.exitCode = testRunner->runPlans(plans, &results.results);
+    results.write(m_options.resultFile);
+    return results.exitCode;
+}
+
+FlatFeature TestController::loadFeature(const std::string& input, const FeatureCache* cache) const
+{
+    auto source = SourceFile::open(input);
+    if (cache)
+    {
+        if (auto cached = cache->load(source->view()))
+        {
+            Logger::debug("Loaded cached feature for: " + input);
+            return std::move(*cached);
+        }
+    }
+
+    // Map the file; tokens and the AST view it rather than copying it. The
+    // parser pulls tokens from the lexer as it goes.
+    Lexer lexer(source->view());
+    Parser parser(lexer);
     std::unique_ptr<FeatureStatement> feature = parser.parseFeature();
     if (!feature)
     {
         throw std::runtime_error("Failed to parse feature from file: " + input);
     }
+    auto flat = FlatFeature::flatten(*feature);
+    if (cache)
+    {
+        cache->store(source->view(), flat);
+    }
+    return flat;
+}
+
+std::vector<std::string> TestController::resolveInputs(const std::string& input)
+{
+    std::vector<std::string> paths;
+    if (std::filesystem::is_directory(input))
+    {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".feature")
+            {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+    else if (isGlobPattern(input) && !std::filesystem::exists(input))
+    {
+        glob_t matches{};
+        if (::glob(input.c_str(), 0, nullptr, &matches) == 0)
+        {
+            paths.assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+        }
+        ::globfree(&matches);
+    }
+    else
+    {
+        paths.push_back(input);
+    }
 
-    return testRunner->runTests(std::move(feature));
+    if (paths.empty())
+    {
+        throw std::runtime_error("No feature files found for: " + input);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
 }
 
 } // namespace pep
@@ -16,8 +16,12 @@
 #pragma once
 
 #include "ITestRunner.h"
+#include "parsing/FeatureCache.h"
+#include "pepino/pepino.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace pep
 {
@@ -29,12 +33,28 @@ namespace pep
 class TestController
 {
 public:
-    TestController(std::unique_ptr<ITestRunner> runner);
+    TestController(std::unique_ptr<ITestRunner> runner, RunOptions options = {});
 
+    // Runs a feature file, or every feature file under a directory or matching
+    // a glob pattern.
     int executeTest(const std::string& input);
+    // Runs several feature files. They are read and parsed concurrently, then
+    // run one after the other in the given order. Parse errors from all files
+    // are reported together and nothing runs if there are any.
+    int executeTests(const std::vector<std::string>& inputs);
+
+    // Expands a directory (recursively, *.feature files) or a glob pattern
+    // into a sorted list of files. Any other input is returned as is.
+    static std::vector<std::string> resolveInputs(const std::string& input);
 
 private:
+    // Compiles the features read from `inputs`, keeps this shard's scenarios
+    // and runs them, writing the result file if one is asked for.
+    int runFeatures(const std::vector<FlatFeature>& features, const std::vector<std::string>& inputs) const;
+    FlatFeature loadFeature(const std::string& input, const FeatureCache* cache) const;
+
     std::unique_ptr<ITestRunner> testRunner;
+    RunOptions m_options;
 };
 
 } // namespace pep
@@ -0,0 +1,106 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace pep
+{
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        m_workers.emplace_back([this] { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_taskReady.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_taskReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_tasks.empty() && m_running == 0; });
+    if (m_error)
+    {
+        std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+}
+
+void ThreadPool::work()
+{
+    std::unique_lock lock(m_mutex);
+    for (;;)
+    {
+        m_taskReady.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+        if (m_tasks.empty())
+        {
+            return; // stopping
+        }
+        auto task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        ++m_running;
+        lock.unlock();
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            lock.lock();
+            if (!m_error)
+            {
+                m_error = std::current_exception();
+            }
+            lock.unlock();
+        }
+        lock.lock();
+        --m_running;
+        if (m_tasks.empty() && m_running == 0)
+        {
+            m_idle.notify_all();
+        }
+    }
+}
+
+} // namespace pep
@@ -0,0 +1,70 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pep
+{
+
+// A fixed set of worker threads running queued tasks.
+class ThreadPool
+{
+public:
+    // 0 threads means one per hardware thread.
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task has finished. Rethrows the first
+    // exception a task let escape, if any.
+    void wait();
+
+    size_t size() const { return m_workers.size(); }
+
+    // Runs fn(i) for every i in [0, count) on the pool and waits for all of them.
+    template <typename Fn> void forEach(size_t count, Fn fn)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            submit([&fn, i] { fn(i); });
+        }
+        wait();
+    }
+
+private:
+    void work();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_taskReady;
+    std::condition_variable m_idle;
+    size_t m_running = 0;
+    bool m_stopping = false;
+    std::exception_ptr m_error;
+};
+
+} // namespace pep
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "WorkStealingScheduler.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+namespace pep
+{
+
+namespace
+{
+// One worker's tasks. Owner and thieves work at opposite ends, so they
+// rarely contend for the same task; a plain lock is enough at scenario
+// granularity.
+class TaskDeque
+{
+public:
+    void push(size_t task) { m_tasks.push_back(task); }
+
+    std::optional<size_t> popFront()
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_tasks.empty())
+            return std::nullopt;
+        const size_t task = m_tasks.front();
+        m_tasks.pop_front();
+        return task;
+    }
+
+    std::optional<size_t> stealBack()
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_tasks.empty())
+            return std::nullopt;
+        const size_t task = m_tasks.back();
+        m_tasks.pop_back();
+        return task;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<size_t> m_tasks;
+};
+} // namespace
+
+std::chrono::nanoseconds WorkStealingScheduler::Stats::idle() const
+{
+    std::chrono::nanoseconds idle{ 0 };
+    for (const auto& workerBusy : busy)
+        idle += wall - workerBusy;
+    return idle;
+}
+
+double WorkStealingScheduler::Stats::efficiency() const
+{
+    const auto available = wall * busy.size();
+    if (available.count() == 0)
+        return 1.0;
+    return 1.0 - static_cast<double>(idle().count()) / static_cast<double>(available.count());
+}
+
+std::string WorkStealingScheduler::Stats::summary() const
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    std::ostringstream out;
+    out.precision(1);
+    out << std::fixed << "Ran " << tasks << " scenarios on " << busy.size() << " workers in "
+        << Milliseconds(wall).count() << " ms; idle worker time " << Milliseconds(idle()).count() << " ms ("
+        << 100.0 * efficiency() << "% busy), " << steals << " stolen";
+    return out.str();
+}
+
+WorkStealingScheduler::WorkStealingScheduler(size_t workers)
+    : m_workers(workers != 0 ? workers : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+WorkStealingScheduler::Stats WorkStealingScheduler::run(size_t count, const std::function<void(size_t)>& task) const
+{
+    const size_t workers = std::max<size_t>(1, std::min(m_workers, count));
+    Stats stats;
+    stats.tasks = count;
+    stats.busy.assign(workers, std::chrono::nanoseconds{ 0 });
+
+    // Contiguous blocks keep neighbouring tasks (the rows of one outline,
+    // say) on one worker for as long as nobody needs to steal them.
+    std::vector<std::unique_ptr<TaskDeque>> deques;
+    for (size_t worker = 0; worker < workers; ++worker)
+    {
+        deques.push_back(std::make_unique<TaskDeque>());
+        for (size_t i = count * worker / workers; i < count * (worker + 1) / workers; ++i)
+            deques.back()->push(i);
+    }
+
+    std::vector<size_t> steals(workers, 0);
+    const auto start = std::chrono::steady_clock::now();
+    auto work = [&](size_t worker)
+    {
+        for (;;)
+        {
+            std::optional<size_t> next = deques[worker]->popFront();
+            // Tasks never add tasks, so once every deque is empty the work
+            // is done.
+            for (size_t offset = 1; !next && offset < workers; ++offset)
+            {
+                next = deques[(worker + offset) % workers]->stealBack();
+                if (next)
+                    ++steals[worker];
+            }
+            if (!next)
+                return;
+            const auto taskStart = std::chrono::steady_clock::now();
+            task(*next);
+            stats.busy[worker] += std::chrono::steady_clock::now() - taskStart;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t worker = 0; worker < workers; ++worker)
+        threads.emplace_back(work, worker);
+    for (auto& thread : threads)
+        thread.join();
+
+    stats.wall = std::chrono::steady_clock::now() - start;
+    for (size_t workerSteals : steals)
+        stats.steals += workerSteals;
+    return stats;
+}
+
+} // namespace pep
@@ -0,0 +1,61 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pep
+{
+
+// Runs a fixed set of independent tasks on a number of worker threads. The
+// tasks are dealt out in contiguous blocks, one deque per worker; a worker
+// takes its own tasks from the front, in order, and once it runs out steals
+// from the back of the others' deques. A few long tasks therefore no longer
+// keep one worker busy while the rest sit idle at the end of the run.
+class WorkStealingScheduler
+{
+public:
+    // How well the work was spread: every worker is busy for part of the
+    // wall time and idle (stealing, or waiting for the others) for the rest.
+    struct Stats
+    {
+        size_t tasks = 0;
+        size_t steals = 0;
+        std::chrono::nanoseconds wall{ 0 };
+        std::vector<std::chrono::nanoseconds> busy; // Per worker
+
+        std::chrono::nanoseconds idle() const;
+        // Busy time over the time all workers were available, in [0, 1].
+        double efficiency() const;
+        std::string summary() const;
+    };
+
+    // 0 workers means one per hardware thread.
+    explicit WorkStealingScheduler(size_t workers = 0);
+
+    // Runs task(i) for every i in [0, count) and returns once all are done.
+    // Tasks must not throw.
+    Stats run(size_t count, const std::function<void(size_t)>& task) const;
+
+private:
+    size_t m_workers;
+};
+
+} // namespace pep
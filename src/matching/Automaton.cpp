@@ -0,0 +1,195 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "Automaton.h"
+
+#include <algorithm>
+
+namespace pep::matching
+{
+
+size_t Automaton::PcsHash::operator()(const std::vector<uint32_t>& pcs) const
+{
+    size_t hash = pcs.size();
+    for (uint32_t pc : pcs)
+        hash = hash * 1099511628211ull ^ pc;
+    return hash;
+}
+
+bool Automaton::add(uint32_t id, std::string_view pattern)
+{
+    const auto compiled = compile(pattern, id, m_program);
+    if (!compiled)
+        return false;
+    m_starts.push_back(compiled->start);
+    reset();
+    return true;
+}
+
+void Automaton::clear()
+{
+    m_program = {};
+    m_starts.clear();
+    reset();
+}
+
+void Automaton::reset() const
+{
+    std::lock_guard lock(m_mutex);
+    m_states.clear();
+    m_stateIds.clear();
+    m_start = Unknown;
+}
+
+// Expands `pcs` to the instructions reachable without consuming a byte, and
+// keeps only those that wait for one (or for the end of the text).
+void Automaton::closure(std::vector<uint32_t>& pcs, bool atBegin, bool atEnd) const
+{
+    m_visited.assign(m_program.insts.size(), 0);
+    m_stack.assign(pcs.rbegin(), pcs.rend());
+    pcs.clear();
+    while (!m_stack.empty())
+    {
+        const uint32_t pc = m_stack.back();
+        m_stack.pop_back();
+        if (m_visited[pc])
+            continue;
+        m_visited[pc] = 1;
+        const Inst& inst = m_program.insts[pc];
+        switch (inst.op)
+        {
+        case Inst::Op::Split:
+            m_stack.push_back(inst.y);
+            m_stack.push_back(inst.x);
+            break;
+        case Inst::Op::Jump:
+            m_stack.push_back(inst.x);
+            break;
+        case Inst::Op::Save:
+            m_stack.push_back(pc + 1);
+            break;
+        case Inst::Op::AssertBegin:
+            if (atBegin)
+                m_stack.push_back(pc + 1);
+            break;
+        case Inst::Op::AssertEnd:
+            if (atEnd)
+                m_stack.push_back(pc + 1);
+            else
+                pcs.push_back(pc);
+            break;
+        case Inst::Op::Set:
+        case Inst::Op::Match:
+            pcs.push_back(pc);
+            break;
+        }
+    }
+    std::sort(pcs.begin(), pcs.end());
+}
+
+int32_t Automaton::stateFor(std::vector<uint32_t>&& pcs) const
+{
+    if (auto it = m_stateIds.find(pcs); it != m_stateIds.end())
+        return it->second;
+    const auto id = static_cast<int32_t>(m_states.size());
+    State state;
+    state.next.fill(Unknown);
+    state.pcs = pcs;
+    m_states.push_back(std::move(state));
+    m_stateIds.emplace(std::move(pcs), id);
+    return id;
+}
+
+int32_t Automaton::step(int32_t state, uint8_t byte) const
+{
+    if (int32_t next = m_states[state].next[byte]; next != Unknown)
+        return next;
+
+    std::vector<uint32_t> pcs;
+    for (uint32_t pc : m_states[state].pcs)
+    {
+        const Inst& inst = m_program.insts[pc];
+        if (inst.op == Inst::Op::Set && m_program.sets[inst.x].test(byte))
+            pcs.push_back(pc + 1);
+    }
+    closure(pcs, false, false);
+
+    if (m_states.size() >= MaxStates)
+    {
+        // Start over, keeping only the state being moved to.
+        m_states.clear();
+        m_stateIds.clear();
+        m_start = Unknown;
+        return stateFor(std::move(pcs));
+    }
+    const int32_t next = stateFor(std::move(pcs));
+    m_states[state].next[byte] = next;
+    return next;
+}
+
+void Automaton::acceptsAtEnd(const std::vector<uint32_t>& pcs, bool atBegin, std::vector<uint32_t>& out) const
+{
+    std::vector<uint32_t> final = pcs;
+    closure(final, atBegin, true);
+    for (uint32_t pc : final)
+    {
+        const Inst& inst = m_program.insts[pc];
+        if (inst.op == Inst::Op::Match)
+            out.push_back(inst.x);
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void Automaton::matchAll(std::string_view text, std::vector<uint32_t>& out) const
+{
+    if (m_starts.empty())
+        return;
+
+    std::lock_guard lock(m_mutex);
+    if (m_start == Unknown)
+    {
+        std::vector<uint32_t> pcs = m_starts;
+        closure(pcs, true, false);
+        m_start = stateFor(std::move(pcs));
+    }
+    if (text.empty())
+    {
+        // Only here can '^' and '$' hold at the same position.
+        std::vector<uint32_t> accepts;
+        acceptsAtEnd(m_states[m_start].pcs, true, accepts);
+        out.insert(out.end(), accepts.begin(), accepts.end());
+        return;
+    }
+
+    int32_t state = m_start;
+    for (char c : text)
+    {
+        state = step(state, static_cast<uint8_t>(c));
+        if (m_states[state].pcs.empty())
+            return; // Nothing can match any more
+    }
+
+    State& last = m_states[state];
+    if (!last.acceptsKnown)
+    {
+        acceptsAtEnd(last.pcs, false, last.accepts);
+        last.acceptsKnown = true;
+    }
+    out.insert(out.end(), last.accepts.begin(), last.accepts.end());
+}
+
+} // namespace pep::matching
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "Regex.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pep::matching
+{
+
+// All step patterns compiled into one NFA, run as a DFA whose states are
+// built the first time a step text reaches them. One pass over a text finds
+// every pattern that matches all of it, however many patterns there are.
+// States are kept across calls; past MaxStates the cache starts over.
+class Automaton
+{
+public:
+    // Adds a pattern. Returns false if it uses syntax the automaton does not
+    // support; the caller has to check that pattern some other way.
+    bool add(uint32_t id, std::string_view pattern);
+    void clear();
+
+    // Appends, in no particular order, the id of every added pattern that
+    // matches the whole of `text`.
+    void matchAll(std::string_view text, std::vector<uint32_t>& out) const;
+
+    size_t patternCount() const { return m_starts.size(); }
+
+private:
+    static constexpr size_t MaxStates = 4096;
+    static constexpr int32_t Unknown = -1;
+
+    struct State
+    {
+        std::vector<uint32_t> pcs; // NFA instructions waiting for a byte or the end
+        std::array<int32_t, 256> next;
+        bool acceptsKnown = false;
+        std::vector<uint32_t> accepts; // Patterns matched if the text ends here
+    };
+
+    struct PcsHash
+    {
+        size_t operator()(const std::vector<uint32_t>& pcs) const;
+    };
+
+    void closure(std::vector<uint32_t>& pcs, bool atBegin, bool atEnd) const;
+    int32_t stateFor(std::vector<uint32_t>&& pcs) const;
+    int32_t step(int32_t state, uint8_t byte) const;
+    void acceptsAtEnd(const std::vector<uint32_t>& pcs, bool atBegin, std::vector<uint32_t>& out) const;
+    void reset() const;
+
+    Program m_program;
+    std::vector<uint32_t> m_starts;
+
+    mutable std::mutex m_mutex;
+    mutable std::vector<State> m_states;
+    mutable std::unordered_map<std::vector<uint32_t>, int32_t, PcsHash> m_stateIds;
+    mutable int32_t m_start = Unknown;
+    mutable std::vector<uint8_t> m_visited;
+    mutable std::vector<uint32_t> m_stack;
+};
+
+} // namespace pep::matching
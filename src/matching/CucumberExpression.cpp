@@ -0,0 +1,521 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "CucumberExpression.h"
+
+#include <atomic>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace pep::matching
+{
+
+namespace
+{
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isSpace(char c)
+{
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+// Length of the longest run of digits at the start of `text`.
+size_t digits(std::string_view text)
+{
+    size_t n = 0;
+    while (n < text.size() && isDigit(text[n]))
+        ++n;
+    return n;
+}
+
+// -?\d+
+bool isInt(std::string_view text)
+{
+    if (!text.empty() && text[0] == '-')
+        text.remove_prefix(1);
+    return !text.empty() && digits(text) == text.size();
+}
+
+// [-+]?\d*\.?\d+ with an optional exponent.
+bool isFloat(std::string_view text)
+{
+    if (!text.empty() && (text[0] == '-' || text[0] == '+'))
+        text.remove_prefix(1);
+    size_t whole = digits(text);
+    text.remove_prefix(whole);
+    size_t fraction = 0;
+    if (!text.empty() && text[0] == '.')
+    {
+        text.remove_prefix(1);
+        fraction = digits(text);
+        if (fraction == 0)
+            return false;
+        text.remove_prefix(fraction);
+    }
+    if (whole + fraction == 0)
+        return false;
+    if (!text.empty() && (text[0] == 'e' || text[0] == 'E'))
+    {
+        text.remove_prefix(1);
+        if (!text.empty() && (text[0] == '-' || text[0] == '+'))
+            text.remove_prefix(1);
+        const size_t exponent = digits(text);
+        if (exponent == 0)
+            return false;
+        text.remove_prefix(exponent);
+    }
+    return text.empty();
+}
+
+struct ParameterType
+{
+    enum class Kind
+    {
+        Int,
+        Float,
+        Word,
+        String,
+        Anonymous,
+        Custom
+    };
+
+    Kind kind;
+    std::function<bool(std::string_view)> accepts; // Custom only
+};
+
+class ParameterTypes
+{
+public:
+    static ParameterTypes& instance()
+    {
+        static ParameterTypes types;
+        return types;
+    }
+
+    void define(std::string name, std::function<bool(std::string_view)> accepts)
+    {
+        std::unique_lock lock(m_mutex);
+        auto& slot = m_types[std::move(name)];
+        // Matchers may still point at the type being replaced.
+        if (slot)
+            m_retired.push_back(std::move(slot));
+        slot = std::make_unique<ParameterType>(ParameterType{ ParameterType::Kind::Custom, std::move(accepts) });
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    // Types live as long as the program, so the pointer stays valid.
+    const ParameterType* find(const std::string& name) const
+    {
+        std::shared_lock lock(m_mutex);
+        auto it = m_types.find(name);
+        return it == m_types.end() ? nullptr : it->second.get();
+    }
+
+    // Changes whenever a type is defined.
+    uint64_t generation() const { return m_generation.load(std::memory_order_acquire); }
+
+private:
+    ParameterTypes()
+    {
+        using Kind = ParameterType::Kind;
+        for (const char* name : { "int", "byte", "short", "long", "biginteger" })
+            m_types[name] = std::make_unique<ParameterType>(ParameterType{ Kind::Int, {} });
+        for (const char* name : { "float", "double", "bigdecimal" })
+            m_types[name] = std::make_unique<ParameterType>(ParameterType{ Kind::Float, {} });
+        m_types["word"] = std::make_unique<ParameterType>(ParameterType{ Kind::Word, {} });
+        m_types["string"] = std::make_unique<ParameterType>(ParameterType{ Kind::String, {} });
+        m_types[""] = std::make_unique<ParameterType>(ParameterType{ Kind::Anonymous, {} });
+    }
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<const ParameterType>> m_types;
+    std::vector<std::unique_ptr<const ParameterType>> m_retired;
+    std::atomic<uint64_t> m_generation{ 0 };
+};
+
+struct Segment
+{
+    enum class Kind
+    {
+        Literal,
+        Optional,
+        Alternation,
+        Parameter
+    };
+
+    Kind kind;
+    std::vector<std::string> texts; // The literal, the optional text, or each alternative
+    std::string parameter;          // Parameter type name
+};
+
+std::vector<Segment> parseExpression(std::string_view expression)
+{
+    std::vector<Segment> segments;
+    std::string literal;
+    auto flush = [&]
+    {
+        if (!literal.empty())
+            segments.push_back({ Segment::Kind::Literal, { std::move(literal) }, {} });
+        literal.clear();
+    };
+    auto malformed = [&](const char* what)
+    { return std::invalid_argument(std::string(what) + " in Cucumber Expression: " + std::string(expression)); };
+
+    // Reads text up to one of `stops`, resolving escapes.
+    size_t pos = 0;
+    auto readText = [&](std::string_view stops)
+    {
+        std::string text;
+        while (pos < expression.size() && stops.find(expression[pos]) == std::string_view::npos)
+        {
+            if (expression[pos] == '\\' && pos + 1 < expression.size())
+                ++pos;
+            text.push_back(expression[pos++]);
+        }
+        return text;
+    };
+
+    while (pos < expression.size())
+    {
+        const char c = expression[pos];
+        if (c == '{')
+        {
+            flush();
+            ++pos;
+            std::string name = readText("{}()/ ");
+            if (pos >= expression.size() || expression[pos] != '}')
+                throw malformed("Unterminated parameter");
+            ++pos;
+            segments.push_back({ Segment::Kind::Parameter, {}, std::move(name) });
+        }
+        else if (c == '(')
+        {
+            flush();
+            ++pos;
+            std::string text = readText("(){}");
+            if (pos >= expression.size() || expression[pos] != ')' || text.empty())
+                throw malformed("Malformed optional text");
+            ++pos;
+            segments.push_back({ Segment::Kind::Optional, { std::move(text) }, {} });
+        }
+        else if (c == '/')
+        {
+            // The alternation covers the word around the slashes.
+            const size_t wordStart = literal.find_last_of(' ') == std::string::npos ? 0 : literal.find_last_of(' ') + 1;
+            std::vector<std::string> alternatives{ literal.substr(wordStart) };
+            literal.erase(wordStart);
+            flush();
+            while (pos < expression.size() && expression[pos] == '/')
+            {
+                ++pos;
+                alternatives.push_back(readText("/ {}()"));
+            }
+            for (const auto& alternative : alternatives)
+            {
+                if (alternative.empty())
+                    throw malformed("Empty alternative");
+            }
+            segments.push_back({ Segment::Kind::Alternation, std::move(alternatives), {} });
+        }
+        else if (c == '}' || c == ')')
+        {
+            throw malformed("Unbalanced bracket");
+        }
+        else
+        {
+            literal += readText("{}()/");
+        }
+    }
+    flush();
+    return segments;
+}
+
+class ExpressionMatcher : public IStepMatcher
+{
+public:
+    explicit ExpressionMatcher(std::vector<Segment> segments) : m_segments(std::move(segments))
+    {
+        for (const auto& segment : m_segments)
+        {
+            if (segment.kind == Segment::Kind::Parameter)
+                ++m_groups;
+        }
+    }
+
+    bool match(std::string_view text, CaptureSpans* captures) const override
+    {
+        // Scratch space reused across matches on the same thread.
+        thread_local Search search;
+        search.text = text;
+        search.captures.clear();
+        search.failed.assign((m_segments.size() + 1) * (text.size() + 1), false);
+        resolveTypes(search.types);
+        if (!matchFrom(search, 0, 0, 0))
+            return false;
+        if (captures)
+            *captures = search.captures;
+        return true;
+    }
+
+    uint32_t groups() const override { return m_groups; }
+
+private:
+    struct Search
+    {
+        std::string_view text;
+        std::vector<const ParameterType*> types; // One per parameter
+        CaptureSpans captures;
+        std::vector<bool> failed; // (segment, position) pairs known not to lead to a match
+    };
+
+    // Depth-first over the ways each segment can match, preferring longer
+    // parameters and present optional text, like the equivalent regex.
+    bool matchFrom(Search& search, size_t segment, size_t pos, size_t parameter) const
+    {
+        const std::string_view text = search.text;
+        if (segment == m_segments.size())
+            return pos == text.size();
+        const size_t memo = segment * (text.size() + 1) + pos;
+        if (search.failed[memo])
+            return false;
+
+        const Segment& current = m_segments[segment];
+        const std::string_view rest = text.substr(pos);
+        bool matched = false;
+        switch (current.kind)
+        {
+        case Segment::Kind::Literal:
+            matched = rest.starts_with(current.texts[0]) &&
+                      matchFrom(search, segment + 1, pos + current.texts[0].size(), parameter);
+            break;
+        case Segment::Kind::Optional:
+            matched = (rest.starts_with(current.texts[0]) &&
+                       matchFrom(search, segment + 1, pos + current.texts[0].size(), parameter)) ||
+                      matchFrom(search, segment + 1, pos, parameter);
+            break;
+        case Segment::Kind::Alternation:
+            for (const auto& alternative : current.texts)
+            {
+                if (rest.starts_with(alternative) &&
+                    matchFrom(search, segment + 1, pos + alternative.size(), parameter))
+                {
+                    matched = true;
+                    break;
+                }
+            }
+            break;
+        case Segment::Kind::Parameter:
+            matched = matchParameter(search, segment, pos, parameter);
+            break;
+        }
+        if (!matched)
+            search.failed[memo] = true;
+        return matched;
+    }
+
+    bool tryCapture(Search& search, size_t segment, size_t pos, size_t parameter, size_t length, size_t inner,
+                    size_t innerLength) const
+    {
+        search.captures.emplace_back(static_cast<uint32_t>(inner), static_cast<uint32_t>(innerLength));
+        if (matchFrom(search, segment + 1, pos + length, parameter + 1))
+            return true;
+        search.captures.pop_back();
+        return false;
+    }
+
+    bool matchParameter(Search& search, size_t segment, size_t pos, size_t parameter) const
+    {
+        using Kind = ParameterType::Kind;
+        const ParameterType& type = *search.types[parameter];
+        const std::string_view rest = search.text.substr(pos);
+
+        if (type.kind == Kind::String)
+        {
+            // "..." or '...', where a backslash escapes the next character.
+            if (rest.empty() || (rest[0] != '"' && rest[0] != '\''))
+                return false;
+            for (size_t i = 1; i < rest.size(); ++i)
+            {
+                if (rest[i] == '\\')
+                    ++i;
+                else if (rest[i] == rest[0])
+                    return tryCapture(search, segment, pos, parameter, i + 1, pos + 1, i - 1);
+            }
+            return false;
+        }
+
+        // The longest run the slot could possibly span; shorter ones are
+        // tried after longer ones.
+        size_t longest = rest.size();
+        if (type.kind == Kind::Word || type.kind == Kind::Int || type.kind == Kind::Float)
+        {
+            longest = 0;
+            while (longest < rest.size() && !isSpace(rest[longest]))
+                ++longest;
+        }
+        const size_t shortest = type.kind == Kind::Anonymous ? 0 : 1;
+        for (size_t length = longest + 1; length-- > shortest;)
+        {
+            const std::string_view slot = rest.substr(0, length);
+            bool accepted = true;
+            switch (type.kind)
+            {
+            case Kind::Int:
+                accepted = isInt(slot);
+                break;
+            case Kind::Float:
+                accepted = isFloat(slot);
+                break;
+            case Kind::Custom:
+                accepted = type.accepts(slot);
+                break;
+            default:
+                break;
+            }
+            if (accepted && tryCapture(search, segment, pos, parameter, length, pos, length))
+                return true;
+        }
+        return false;
+    }
+
+    // The parameter types as of one registry generation. Never changed once
+    // published, so matching threads read them without a lock.
+    struct ResolvedTypes
+    {
+        uint64_t generation = 0;
+        std::vector<const ParameterType*> types;
+    };
+
+    // Looks the parameter types up again only after one has been defined.
+    void resolveTypes(std::vector<const ParameterType*>& types) const
+    {
+        const uint64_t generation = ParameterTypes::instance().generation();
+        const ResolvedTypes* resolved = m_resolved.load(std::memory_order_acquire);
+        if (!resolved || resolved->generation != generation)
+            resolved = reresolveTypes(generation);
+        types.assign(resolved->types.begin(), resolved->types.end());
+    }
+
+    const ResolvedTypes* reresolveTypes(uint64_t generation) const
+    {
+        std::lock_guard lock(m_typesMutex);
+        if (const ResolvedTypes* current = m_resolved.load(std::memory_order_relaxed);
+            current && current->generation == generation)
+            return current;
+
+        const auto& registry = ParameterTypes::instance();
+        auto resolved = std::make_unique<ResolvedTypes>();
+        resolved->generation = generation;
+        for (const auto& segment : m_segments)
+        {
+            if (segment.kind != Segment::Kind::Parameter)
+                continue;
+            const ParameterType* type = registry.find(segment.parameter);
+            if (!type)
+                throw std::invalid_argument("Undefined parameter type {" + segment.parameter + "}");
+            resolved->types.push_back(type);
+        }
+        // Earlier snapshots are kept: another thread may still be reading one.
+        m_snapshots.push_back(std::move(resolved));
+        m_resolved.store(m_snapshots.back().get(), std::memory_order_release);
+        return m_snapshots.back().get();
+    }
+
+    std::vector<Segment> m_segments;
+    uint32_t m_groups = 0;
+    mutable std::mutex m_typesMutex; // Only taken to publish a new snapshot
+    mutable std::vector<std::unique_ptr<const ResolvedTypes>> m_snapshots;
+    mutable std::atomic<const ResolvedTypes*> m_resolved{ nullptr };
+};
+} // namespace
+
+bool isCucumberExpression(std::string_view pattern)
+{
+    if (pattern.empty() || pattern.front() == '^' || pattern.back() == '$')
+        return false;
+    for (size_t open = pattern.find('{'); open != std::string_view::npos; open = pattern.find('{', open + 1))
+    {
+        if (open > 0 && pattern[open - 1] == '\\')
+            continue;
+        size_t end = open + 1;
+        while (end < pattern.size() && (std::isalpha(static_cast<unsigned char>(pattern[end])) || pattern[end] == '_'))
+            ++end;
+        if (end < pattern.size() && pattern[end] == '}')
+            return true;
+    }
+    return false;
+}
+
+std::shared_ptr<const IStepMatcher> makeExpressionMatcher(std::string_view expression)
+{
+    return std::make_shared<ExpressionMatcher>(parseExpression(expression));
+}
+
+int expressionSpecificity(std::string_view expression)
+{
+    // Anchored at both ends, as a regex with ^ and $ would be.
+    int score = 6;
+    for (const auto& segment : parseExpression(expression))
+    {
+        switch (segment.kind)
+        {
+        case Segment::Kind::Literal:
+        case Segment::Kind::Optional:
+        case Segment::Kind::Alternation:
+            for (const auto& text : segment.texts)
+            {
+                for (char c : text)
+                {
+                    if (std::isalnum(static_cast<unsigned char>(c)))
+                        score += 4;
+                }
+            }
+            break;
+        case Segment::Kind::Parameter:
+            // {int} ranks like \d, anything else like \w.
+            score += segment.parameter == "int" ? 2 : 1;
+            break;
+        }
+    }
+    return score;
+}
+
+PatternShape analyzeExpression(std::string_view expression)
+{
+    PatternShape shape;
+    const auto segments = parseExpression(expression);
+    if (!segments.empty() && segments.front().kind == Segment::Kind::Literal)
+    {
+        shape.tier = Tier::Prefix;
+        shape.literal = segments.front().texts[0];
+    }
+    return shape;
+}
+
+void defineParameterType(std::string name, std::function<bool(std::string_view)> accepts)
+{
+    ParameterTypes::instance().define(std::move(name), std::move(accepts));
+}
+
+} // namespace pep::matching
@@ -0,0 +1,52 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "StepIndex.h"
+#include "StepMatcher.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pep::matching
+{
+
+// Whether a step pattern is a Cucumber Expression rather than a regex: it
+// names a parameter type ("a number {int}") and is not anchored with ^ or $.
+bool isCucumberExpression(std::string_view pattern);
+
+// Compiles a Cucumber Expression into a scanner over its literal text,
+// optional text "(s)", alternatives "a/b" and parameter slots; no regex
+// engine is involved. Each parameter is one capture; {string} captures the
+// text between the quotes. Throws std::invalid_argument for malformed
+// expressions. Parameter types are looked up when matching, so custom types
+// may be defined after the steps using them are registered.
+std::shared_ptr<const IStepMatcher> makeExpressionMatcher(std::string_view expression);
+
+// Rank of an expression on the same scale as StepRegistry's regex ranking:
+// it scores like the equivalent anchored regex would.
+int expressionSpecificity(std::string_view expression);
+
+// The literal text every match of the expression starts with.
+PatternShape analyzeExpression(std::string_view expression);
+
+// Defines (or redefines) the parameter type {name}: a slot may hold any text
+// `accepts` returns true for. Longer slots are preferred.
+void defineParameterType(std::string name, std::function<bool(std::string_view)> accepts);
+
+} // namespace pep::matching
@@ -0,0 +1,295 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "Regex.h"
+
+#include <limits>
+
+namespace pep::matching
+{
+
+std::optional<Regex> Regex::compile(std::string_view pattern)
+{
+    Regex regex;
+    const auto compiled = matching::compile(pattern, 0, regex.m_program);
+    if (!compiled)
+        return std::nullopt;
+    regex.m_groups = compiled->groups;
+    return regex;
+}
+
+namespace
+{
+constexpr uint32_t Unset = std::numeric_limits<uint32_t>::max();
+
+// The threads alive at one text position, in priority order. Each thread owns
+// a row of capture slots; `index` makes "is this pc already here" O(1).
+struct ThreadList
+{
+    ThreadList(size_t insts, size_t slots) : slots(slots), index(insts, Unset) {}
+
+    bool contains(uint32_t pc) const { return index[pc] != Unset && index[pc] < pcs.size() && pcs[index[pc]] == pc; }
+
+    void add(uint32_t pc, const std::vector<uint32_t>& caps)
+    {
+        index[pc] = static_cast<uint32_t>(pcs.size());
+        pcs.push_back(pc);
+        this->caps.insert(this->caps.end(), caps.begin(), caps.end());
+    }
+
+    void clear()
+    {
+        pcs.clear();
+        caps.clear();
+    }
+
+    const uint32_t* capsOf(size_t thread) const { return caps.data() + thread * slots; }
+
+    size_t slots;
+    std::vector<uint32_t> index;
+    std::vector<uint32_t> pcs;
+    std::vector<uint32_t> caps;
+};
+
+// Follows every instruction that consumes nothing from `start`, adding the
+// ones that wait on a byte (or Match) to `list` in priority order. Saves are
+// undone on the way back so sibling branches see the captures they started
+// with, as a backtracking matcher would.
+void addThread(const ProgramView& program,
+               ThreadList& list,
+               uint32_t start,
+               std::vector<uint32_t>& caps,
+               uint32_t pos,
+               uint32_t length,
+               std::vector<std::pair<uint32_t, uint32_t>>& stack)
+{
+    // Entries are (pc, Unset) to visit a pc, or (slot | RestoreBit, value) to
+    // put a capture slot back.
+    constexpr uint32_t RestoreBit = 1u << 31;
+    stack.clear();
+    stack.emplace_back(start, Unset);
+    while (!stack.empty())
+    {
+        const auto [pc, value] = stack.back();
+        stack.pop_back();
+        if (pc & RestoreBit)
+        {
+            caps[pc & ~RestoreBit] = value;
+            continue;
+        }
+        if (list.contains(pc))
+            continue;
+        const Inst& inst = program.insts[pc];
+        switch (inst.op)
+        {
+        case Inst::Op::Split:
+            // Mark the split itself so a loop that matches nothing stops here.
+            list.index[pc] = static_cast<uint32_t>(list.pcs.size());
+            list.pcs.push_back(pc);
+            list.caps.insert(list.caps.end(), caps.begin(), caps.end());
+            stack.emplace_back(inst.y, Unset);
+            stack.emplace_back(inst.x, Unset);
+            break;
+        case Inst::Op::Jump:
+            stack.emplace_back(inst.x, Unset);
+            break;
+        case Inst::Op::Save:
+            stack.emplace_back(inst.x | RestoreBit, caps[inst.x]);
+            caps[inst.x] = pos;
+            stack.emplace_back(pc + 1, Unset);
+            break;
+        case Inst::Op::AssertBegin:
+            if (pos == 0)
+                stack.emplace_back(pc + 1, Unset);
+            break;
+        case Inst::Op::AssertEnd:
+            if (pos == length)
+                stack.emplace_back(pc + 1, Unset);
+            break;
+        case Inst::Op::Set:
+        case Inst::Op::Match:
+            list.add(pc, caps);
+            break;
+        }
+    }
+}
+
+// Above this many (instruction, position) pairs the backtracker's visited set
+// gets too big to clear for every match.
+constexpr size_t MaxBacktrackStates = 256 * 1024;
+
+void reportCaptures(const uint32_t* slots, uint32_t groups, uint32_t length, CaptureSpans* captures)
+{
+    if (!captures)
+        return;
+    captures->clear();
+    for (uint32_t group = 1; group <= groups; ++group)
+    {
+        const uint32_t first = slots[2 * group];
+        const uint32_t last = slots[2 * group + 1];
+        if (first == Unset || last == Unset)
+            captures->emplace_back(length, 0);
+        else
+            captures->emplace_back(first, last - first);
+    }
+}
+
+// Scratch space reused across matches on the same thread.
+struct BacktrackState
+{
+    struct Job
+    {
+        uint32_t pc;
+        uint32_t pos; // Position, or the old slot value when restoring
+        bool restore;
+    };
+
+    std::vector<uint64_t> visited;
+    std::vector<Job> jobs;
+    std::vector<uint32_t> slots;
+};
+// Depth-first in priority order, so the first path to reach Match at the end
+// is the one std::regex picks. A (pc, pos) pair that failed once fails again,
+// whatever the captures, so it is never retried.
+bool backtrack(const ProgramView& program, std::string_view text, CaptureSpans* captures)
+{
+    thread_local BacktrackState state;
+    const auto length = static_cast<uint32_t>(text.size());
+    const size_t stride = text.size() + 1;
+    state.visited.assign((program.size * stride + 63) / 64, 0);
+    state.slots.assign(2 * (static_cast<size_t>(program.groups) + 1), Unset);
+    state.jobs.clear();
+    state.jobs.push_back({ 0, 0, false });
+
+    while (!state.jobs.empty())
+    {
+        const auto job = state.jobs.back();
+        state.jobs.pop_back();
+        if (job.restore)
+        {
+            state.slots[job.pc] = job.pos;
+            continue;
+        }
+        uint32_t pc = job.pc;
+        uint32_t pos = job.pos;
+        while (true)
+        {
+            const size_t bit = pc * stride + pos;
+            if (state.visited[bit / 64] & (uint64_t(1) << (bit % 64)))
+                break;
+            state.visited[bit / 64] |= uint64_t(1) << (bit % 64);
+
+            const Inst& inst = program.insts[pc];
+            bool advance = true;
+            switch (inst.op)
+            {
+            case Inst::Op::Set:
+                advance = pos < length && program.sets[inst.x].test(static_cast<uint8_t>(text[pos]));
+                if (advance)
+                    ++pos;
+                ++pc;
+                break;
+            case Inst::Op::Split:
+                state.jobs.push_back({ inst.y, pos, false });
+                pc = inst.x;
+                break;
+            case Inst::Op::Jump:
+                pc = inst.x;
+                break;
+            case Inst::Op::Save:
+                state.jobs.push_back({ inst.x, state.slots[inst.x], true });
+                state.slots[inst.x] = pos;
+                ++pc;
+                break;
+            case Inst::Op::AssertBegin:
+                advance = pos == 0;
+                ++pc;
+                break;
+            case Inst::Op::AssertEnd:
+                advance = pos == length;
+                ++pc;
+                break;
+            case Inst::Op::Match:
+                if (pos == length)
+                {
+                    reportCaptures(state.slots.data(), program.groups, length, captures);
+                    return true;
+                }
+                advance = false;
+                break;
+            }
+            if (!advance)
+                break;
+        }
+    }
+    return false;
+}
+
+bool pikeVM(const ProgramView& program, std::string_view text, CaptureSpans* captures)
+{
+    const size_t slots = 2 * (static_cast<size_t>(program.groups) + 1);
+    const auto length = static_cast<uint32_t>(text.size());
+    ThreadList current(program.size, slots);
+    ThreadList next(program.size, slots);
+    std::vector<uint32_t> caps(slots, Unset);
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+
+    addThread(program, current, 0, caps, 0, length, stack);
+    for (uint32_t pos = 0; pos < length && !current.pcs.empty(); ++pos)
+    {
+        const auto byte = static_cast<uint8_t>(text[pos]);
+        next.clear();
+        for (size_t thread = 0; thread < current.pcs.size(); ++thread)
+        {
+            const Inst& inst = program.insts[current.pcs[thread]];
+            if (inst.op != Inst::Op::Set || !program.sets[inst.x].test(byte))
+                continue;
+            const uint32_t* row = current.capsOf(thread);
+            caps.assign(row, row + slots);
+            addThread(program, next, current.pcs[thread] + 1, caps, pos + 1, length, stack);
+        }
+        std::swap(current, next);
+    }
+
+    // Only a thread reaching Match at the end matches the whole text; the
+    // first one in priority order is the match std::regex would report.
+    for (size_t thread = 0; thread < current.pcs.size(); ++thread)
+    {
+        if (program.insts[current.pcs[thread]].op != Inst::Op::Match)
+            continue;
+        reportCaptures(current.capsOf(thread), program.groups, length, captures);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool Regex::match(std::string_view text, CaptureSpans* captures) const
+{
+    return matchProgram({ m_program.insts.data(), m_program.insts.size(), m_program.sets.data(), m_groups },
+                        text,
+                        captures);
+}
+
+bool matchProgram(const ProgramView& program, std::string_view text, CaptureSpans* captures)
+{
+    if (program.size * (text.size() + 1) <= MaxBacktrackStates)
+        return backtrack(program, text, captures);
+    return pikeVM(program, text, captures);
+}
+
+} // namespace pep::matching
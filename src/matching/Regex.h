@@ -0,0 +1,51 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "pepino/steps/RegexProgram.h"
+
+#include <optional>
+#include <string_view>
+
+namespace pep::matching
+{
+
+// One compiled pattern. Short texts are matched by a backtracker that never
+// visits the same (instruction, position) twice; longer ones by a Pike VM,
+// where every NFA thread advances in lock step. Either way a match costs at
+// most O(text length x pattern size), and alternatives are tried in priority
+// order so captures come out as std::regex reports them.
+class Regex
+{
+public:
+    // Nothing if the pattern is outside the supported subset.
+    static std::optional<Regex> compile(std::string_view pattern);
+
+    uint32_t groups() const { return m_groups; }
+
+    // Whether the pattern matches all of `text`. On a match, `captures` (if
+    // given) receives one span per group; a group that took no part in the
+    // match is reported as {text.size(), 0}.
+    bool match(std::string_view text, CaptureSpans* captures) const;
+
+private:
+    Regex() = default;
+
+    Program m_program;
+    uint32_t m_groups = 0;
+};
+
+} // namespace pep::matching
@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "StepIndex.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace pep::matching
+{
+
+namespace
+{
+bool isQuantifier(char c)
+{
+    return c == '?' || c == '*' || c == '+' || c == '{';
+}
+
+bool isMeta(char c)
+{
+    return std::string_view(".[](){}*+?|^$\\").find(c) != std::string_view::npos;
+}
+
+// Whether the pattern has a '|' outside of any group or class.
+bool hasTopLevelAlternation(std::string_view pattern)
+{
+    int depth = 0;
+    bool inClass = false;
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+        const char c = pattern[i];
+        if (c == '\\')
+            ++i;
+        else if (inClass)
+            inClass = c != ']';
+        else if (c == '[')
+            inClass = true;
+        else if (c == '(')
+            ++depth;
+        else if (c == ')')
+            --depth;
+        else if (c == '|' && depth == 0)
+            return true;
+    }
+    return false;
+}
+} // namespace
+
+PatternShape analyzePattern(std::string_view pattern)
+{
+    PatternShape shape;
+    if (hasTopLevelAlternation(pattern))
+    {
+        return shape;
+    }
+
+    size_t pos = 0;
+    size_t end = pattern.size();
+    if (pos < end && pattern[pos] == '^')
+        ++pos;
+    // A trailing '$' is an anchor unless it is escaped.
+    if (end > pos && pattern[end - 1] == '$')
+    {
+        size_t backslashes = 0;
+        while (end - 1 - backslashes > pos && pattern[end - 2 - backslashes] == '\\')
+            ++backslashes;
+        if (backslashes % 2 == 0)
+            --end;
+    }
+
+    std::string literal;
+    while (pos < end)
+    {
+        char c = pattern[pos];
+        size_t width = 1;
+        if (c == '\\')
+        {
+            if (pos + 1 >= end)
+                break;
+            c = pattern[pos + 1];
+            // \d, \w, \b, back-references and the like are not literals.
+            if (std::isalnum(static_cast<unsigned char>(c)))
+                break;
+            width = 2;
+        }
+        else if (isMeta(c))
+        {
+            break;
+        }
+        if (pos + width < end && isQuantifier(pattern[pos + width]))
+            break;
+        literal.push_back(c);
+        pos += width;
+    }
+
+    if (pos == end)
+        shape.tier = Tier::Exact;
+    else if (!literal.empty())
+        shape.tier = Tier::Prefix;
+    else
+        return shape;
+    shape.literal = std::move(literal);
+    return shape;
+}
+
+uint32_t StepIndex::child(uint32_t node, char c) const
+{
+    const auto& children = m_trie[node].children;
+    auto it = std::lower_bound(
+        children.begin(), children.end(), c, [](const auto& entry, char key) { return entry.first < key; });
+    return it != children.end() && it->first == c ? it->second : 0;
+}
+
+void StepIndex::add(uint32_t id, const PatternShape& shape)
+{
+    switch (shape.tier)
+    {
+    case Tier::Exact:
+        m_exact[shape.literal].push_back(id);
+        break;
+    case Tier::Prefix:
+    {
+        uint32_t node = 0;
+        for (char c : shape.literal)
+        {
+            uint32_t next = child(node, c);
+            if (next == 0)
+            {
+                next = static_cast<uint32_t>(m_trie.size());
+                m_trie.emplace_back();
+                auto& children = m_trie[node].children;
+                auto it = std::lower_bound(children.begin(),
+                                           children.end(),
+                                           c,
+                                           [](const auto& entry, char key) { return entry.first < key; });
+                children.insert(it, { c, next });
+            }
+            node = next;
+        }
+        m_trie[node].ids.push_back(id);
+        break;
+    }
+    case Tier::Regex:
+        m_regex.push_back(id);
+        break;
+    }
+}
+
+void StepIndex::clear()
+{
+    m_exact.clear();
+    m_trie.assign(1, TrieNode{});
+    m_regex.clear();
+}
+
+void StepIndex::collect(std::string_view text, std::vector<Candidate>& out) const
+{
+    if (auto it = m_exact.find(std::string(text)); it != m_exact.end())
+    {
+        for (uint32_t id : it->second)
+            out.push_back({ id, true });
+    }
+
+    uint32_t node = 0;
+    for (char c : text)
+    {
+        node = child(node, c);
+        if (node == 0)
+            break;
+        for (uint32_t id : m_trie[node].ids)
+            out.push_back({ id, false });
+    }
+
+    for (uint32_t id : m_regex)
+        out.push_back({ id, false });
+}
+
+} // namespace pep::matching
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pep::matching
+{
+
+// How a step pattern can be looked up.
+enum class Tier
+{
+    Exact,  // The pattern only matches one literal text.
+    Prefix, // Every match starts with a literal prefix.
+    Regex   // Nothing is known without running the regex.
+};
+
+struct PatternShape
+{
+    Tier tier = Tier::Regex;
+    // The whole text for Exact, the prefix for Prefix, empty for Regex.
+    std::string literal;
+};
+
+// Reads the literal part of an ECMAScript pattern: anchors are dropped,
+// escaped punctuation is literal, and the scan stops at the first class,
+// group or quantifier (a quantified character is not part of the prefix).
+// Patterns with a top-level alternation have no prefix.
+PatternShape analyzePattern(std::string_view pattern);
+
+// Indexes step definitions by the shape of their pattern, so the candidates
+// for a step text are found with one hash lookup and one walk down a trie of
+// prefixes, no matter how many definitions are registered. Only definitions
+// without a literal prefix are candidates for every text.
+class StepIndex
+{
+public:
+    struct Candidate
+    {
+        uint32_t id;
+        bool exact; // Known to match; no regex needed.
+    };
+
+    void add(uint32_t id, const PatternShape& shape);
+    void clear();
+
+    // Appends every definition that could match `text`. Prefix and regex
+    // candidates still have to be confirmed with their regex.
+    void collect(std::string_view text, std::vector<Candidate>& out) const;
+
+private:
+    struct TrieNode
+    {
+        std::vector<std::pair<char, uint32_t>> children; // Sorted by character
+        std::vector<uint32_t> ids;                       // Prefixes ending here
+    };
+
+    uint32_t child(uint32_t node, char c) const;
+
+    std::unordered_map<std::string, std::vector<uint32_t>> m_exact;
+    std::vector<TrieNode> m_trie{ TrieNode{} };
+    std::vector<uint32_t> m_regex;
+};
+
+} // namespace pep::matching
@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "StepMatcher.h"
+
+#include <regex>
+
+namespace pep::matching
+{
+
+namespace
+{
+class StdRegexMatcher : public IStepMatcher
+{
+public:
+    explicit StdRegexMatcher(const std::string& pattern) : m_regex(pattern) {}
+
+    bool match(std::string_view text, CaptureSpans* captures) const override
+    {
+        std::match_results<std::string_view::const_iterator> m;
+        if (!std::regex_match(text.begin(), text.end(), m, m_regex))
+            return false;
+        if (captures)
+        {
+            captures->clear();
+            for (size_t i = 1; i < m.size(); ++i)
+                captures->emplace_back(static_cast<uint32_t>(m.position(i)), static_cast<uint32_t>(m.length(i)));
+        }
+        return true;
+    }
+
+    uint32_t groups() const override { return static_cast<uint32_t>(m_regex.mark_count()); }
+
+private:
+    std::regex m_regex;
+};
+
+class BuiltinMatcher : public IStepMatcher
+{
+public:
+    explicit BuiltinMatcher(Regex regex) : m_regex(std::move(regex)) {}
+
+    bool match(std::string_view text, CaptureSpans* captures) const override { return m_regex.match(text, captures); }
+    uint32_t groups() const override { return m_regex.groups(); }
+
+private:
+    Regex m_regex;
+};
+
+class ProgramMatcher : public IStepMatcher
+{
+public:
+    explicit ProgramMatcher(const ProgramView& program) : m_program(program) {}
+
+    bool match(std::string_view text, CaptureSpans* captures) const override
+    {
+        return matchProgram(m_program, text, captures);
+    }
+    uint32_t groups() const override { return m_program.groups; }
+
+private:
+    const ProgramView& m_program;
+};
+} // namespace
+
+std::shared_ptr<const IStepMatcher> makeStdRegexMatcher(const std::string& pattern)
+{
+    return std::make_shared<StdRegexMatcher>(pattern);
+}
+
+std::shared_ptr<const IStepMatcher> makeBuiltinMatcher(std::string_view pattern)
+{
+    auto regex = Regex::compile(pattern);
+    if (!regex)
+        return nullptr;
+    return std::make_shared<BuiltinMatcher>(std::move(*regex));
+}
+
+std::shared_ptr<const IStepMatcher> makeProgramMatcher(const ProgramView& program)
+{
+    return std::make_shared<ProgramMatcher>(program);
+}
+
+std::shared_ptr<const IStepMatcher> makeMatcher(const std::string& pattern, types::RegexBackend backend)
+{
+    if (backend == types::RegexBackend::Builtin)
+    {
+        if (auto matcher = makeBuiltinMatcher(pattern))
+            return matcher;
+    }
+    return makeStdRegexMatcher(pattern);
+}
+
+} // namespace pep::matching
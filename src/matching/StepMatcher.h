@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "Regex.h"
+#include "pepino/types/types.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pep::matching
+{
+
+// Decides whether a step definition's pattern matches a step text and what
+// it captures. Implementations are immutable once built and safe to share
+// between threads.
+class IStepMatcher
+{
+public:
+    virtual ~IStepMatcher() = default;
+
+    // Whether the pattern matches all of `text`; on a match `captures` (if
+    // given) receives one span per capturing group.
+    virtual bool match(std::string_view text, CaptureSpans* captures) const = 0;
+    virtual uint32_t groups() const = 0;
+};
+
+// std::regex, ECMAScript grammar. Accepts every pattern std::regex does and
+// throws std::regex_error for the rest.
+std::shared_ptr<const IStepMatcher> makeStdRegexMatcher(const std::string& pattern);
+
+// The built-in Pike VM; null if the pattern is outside its subset.
+std::shared_ptr<const IStepMatcher> makeBuiltinMatcher(std::string_view pattern);
+
+// Runs a program compiled at build time (see StaticPattern); `program` has to
+// outlive the matcher.
+std::shared_ptr<const IStepMatcher> makeProgramMatcher(const ProgramView& program);
+
+// A matcher for `pattern` on the given backend. The built-in backend hands
+// patterns it cannot compile to std::regex.
+std::shared_ptr<const IStepMatcher> makeMatcher(const std::string& pattern, types::RegexBackend backend);
+
+} // namespace pep::matching
@@ -0,0 +1,398 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "FeatureCache.h"
+
+#include "../Logger.h"
+#include "Parser.h"
+#include "SourceFile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+
+#include <unistd.h>
+
+namespace pep
+{
+
+namespace
+{
+constexpr char Magic[4] = { 'P', 'E', 'P', 'C' };
+
+struct Header
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t contentHash;
+    uint64_t sourceSize;
+    uint64_t payloadSize;
+    uint64_t payloadHash;
+};
+static_assert(std::is_trivially_copyable_v<Header>);
+
+constexpr uint32_t entryVersion()
+{
+    return FeatureCache::FormatVersion << 16 | Parser::Version;
+}
+
+uint64_t fnv1a(std::string_view bytes)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : bytes)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Visits every field of a FlatFeature in the order they are stored, so
+// writing and reading cannot drift apart.
+template <typename Feature, typename Visitor> void visitFields(Feature& feature, Visitor&& visit)
+{
+    visit(feature.name);
+    visit(feature.tags);
+    visit(feature.background);
+    visit(feature.hasBackground);
+    visit(feature.scenarioName);
+    visit(feature.scenarioTags);
+    visit(feature.scenarioSteps);
+    visit(feature.scenarioOutline);
+    visit(feature.scenarioExamples);
+    visit(feature.stepType);
+    visit(feature.stepKeyword);
+    visit(feature.stepTokens);
+    visit(feature.stepText);
+    visit(feature.tokenType);
+    visit(feature.tokenText);
+    visit(feature.examplesHeaders);
+    visit(feature.examplesRows);
+    visit(feature.rowCells);
+    visit(feature.cellText);
+    visit(feature.tagText);
+}
+
+template <typename T> struct IsArray : std::false_type
+{
+};
+template <typename T> struct IsArray<std::vector<T>> : std::true_type
+{
+};
+
+// Symbols are process-local, so an entry carries its own string table and
+// stores each symbol as an index into it.
+class Writer
+{
+public:
+    template <typename T> void operator()(const T& field)
+    {
+        if constexpr (std::is_same_v<T, Symbol>)
+        {
+            const uint32_t index = local(field);
+            append(&index, sizeof(index));
+        }
+        else if constexpr (std::is_same_v<T, std::vector<Symbol>>)
+        {
+            const uint64_t count = field.size();
+            append(&count, sizeof(count));
+            for (Symbol symbol : field)
+                (*this)(symbol);
+        }
+        else if constexpr (IsArray<T>::value)
+        {
+            static_assert(std::is_trivially_copyable_v<typename T::value_type>);
+            const uint64_t count = field.size();
+            append(&count, sizeof(count));
+            append(field.data(), count * sizeof(typename T::value_type));
+        }
+        else
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            append(&field, sizeof(T));
+        }
+    }
+
+    // The string table followed by the fields.
+    std::string bytes() const
+    {
+        std::string out;
+        const uint64_t count = m_table.size();
+        out.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (Symbol symbol : m_table)
+        {
+            const auto text = symbol.view();
+            const uint32_t size = static_cast<uint32_t>(text.size());
+            out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+            out.append(text);
+        }
+        return out + m_fields;
+    }
+
+private:
+    uint32_t local(Symbol symbol)
+    {
+        auto [it, inserted] = m_local.try_emplace(symbol, static_cast<uint32_t>(m_table.size()));
+        if (inserted)
+            m_table.push_back(symbol);
+        return it->second;
+    }
+
+    void append(const void* data, size_t size) { m_fields.append(static_cast<const char*>(data), size); }
+
+    std::string m_fields;
+    std::vector<Symbol> m_table;
+    std::unordered_map<Symbol, uint32_t> m_local;
+};
+
+class Reader
+{
+public:
+    explicit Reader(std::string_view bytes) : m_bytes(bytes) {}
+
+    // Interns the entry's string table; call before reading any field.
+    void readTable()
+    {
+        uint64_t count = 0;
+        read(&count, sizeof(count));
+        if (!ok || count > (m_bytes.size() - m_offset) / sizeof(uint32_t))
+        {
+            ok = false;
+            return;
+        }
+        m_table.reserve(count);
+        for (uint64_t i = 0; i < count && ok; ++i)
+        {
+            uint32_t size = 0;
+            read(&size, sizeof(size));
+            if (!ok || size > m_bytes.size() - m_offset)
+            {
+                ok = false;
+                return;
+            }
+            m_table.push_back(intern(m_bytes.substr(m_offset, size)));
+            m_offset += size;
+        }
+    }
+
+    template <typename T> void operator()(T& field)
+    {
+        if constexpr (std::is_same_v<T, Symbol>)
+        {
+            uint32_t index = 0;
+            read(&index, sizeof(index));
+            if (!ok || index >= m_table.size())
+            {
+                ok = false;
+                return;
+            }
+            field = m_table[index];
+        }
+        else if constexpr (IsArray<T>::value)
+        {
+            uint64_t count = 0;
+            read(&count, sizeof(count));
+            const size_t elementSize = std::is_same_v<T, std::vector<Symbol>> ? sizeof(uint32_t)
+                                                                               : sizeof(typename T::value_type);
+            if (!ok || count > (m_bytes.size() - m_offset) / elementSize)
+            {
+                ok = false;
+                return;
+            }
+            field.resize(count);
+            if constexpr (std::is_same_v<T, std::vector<Symbol>>)
+            {
+                for (auto& symbol : field)
+                    (*this)(symbol);
+            }
+            else
+            {
+                read(field.data(), count * elementSize);
+            }
+        }
+        else
+        {
+            read(&field, sizeof(T));
+        }
+    }
+
+    bool atEnd() const { return m_offset == m_bytes.size(); }
+    bool ok = true;
+
+private:
+    void read(void* data, size_t size)
+    {
+        if (!ok || size > m_bytes.size() - m_offset)
+        {
+            ok = false;
+            return;
+        }
+        std::memcpy(data, m_bytes.data() + m_offset, size);
+        m_offset += size;
+    }
+
+    std::string_view m_bytes;
+    size_t m_offset = 0;
+    std::vector<Symbol> m_table;
+};
+
+// Every index must stay inside its array; a stale or damaged entry that passed
+// the checksum must still never be trusted blindly.
+bool isConsistent(const FlatFeature& f)
+{
+    auto inside = [](FlatFeature::Range range, size_t size)
+    { return static_cast<uint64_t>(range.first) + range.count <= size; };
+    auto allInside = [&](const std::vector<FlatFeature::Range>& ranges, size_t size)
+    {
+        for (const auto& range : ranges)
+        {
+            if (!inside(range, size))
+                return false;
+        }
+        return true;
+    };
+    const size_t scenarios = f.scenarioName.size();
+    const size_t steps = f.stepType.size();
+    const size_t examples = f.examplesHeaders.size();
+    if (f.scenarioTags.size() != scenarios || f.scenarioSteps.size() != scenarios ||
+        f.scenarioOutline.size() != scenarios || f.scenarioExamples.size() != scenarios ||
+        f.stepKeyword.size() != steps || f.stepTokens.size() != steps || f.stepText.size() != steps ||
+        f.tokenText.size() != f.tokenType.size() || f.examplesRows.size() != examples)
+    {
+        return false;
+    }
+    for (auto index : f.scenarioExamples)
+    {
+        if (index != FlatFeature::None && index >= examples)
+            return false;
+    }
+    return inside(f.tags, f.tagText.size()) && inside(f.background, steps) &&
+           allInside(f.scenarioTags, f.tagText.size()) && allInside(f.scenarioSteps, steps) &&
+           allInside(f.stepTokens, f.tokenType.size()) && allInside(f.examplesHeaders, f.cellText.size()) &&
+           allInside(f.examplesRows, f.rowCells.size()) && allInside(f.rowCells, f.cellText.size());
+}
+} // namespace
+
+FeatureCache::FeatureCache(std::filesystem::path directory) : m_directory(std::move(directory))
+{
+}
+
+uint64_t FeatureCache::contentHash(std::string_view source)
+{
+    return fnv1a(source);
+}
+
+std::filesystem::path FeatureCache::entryPath(std::string_view source) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.pepc", static_cast<unsigned long long>(contentHash(source)));
+    return m_directory / name;
+}
+
+std::optional<FlatFeature> FeatureCache::load(std::string_view source) const
+{
+    const auto path = entryPath(source);
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error))
+    {
+        return std::nullopt;
+    }
+
+    std::shared_ptr<const SourceFile> entry;
+    try
+    {
+        entry = SourceFile::open(path.string());
+    }
+    catch (const std::exception& e)
+    {
+        Logger::warn("Ignoring unreadable cache entry: " + std::string(e.what()));
+        return std::nullopt;
+    }
+    const auto bytes = entry->view();
+
+    Header header{};
+    if (bytes.size() < sizeof(Header))
+    {
+        return std::nullopt;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+    const auto payload = bytes.substr(sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != entryVersion() ||
+        header.contentHash != contentHash(source) || header.sourceSize != source.size() ||
+        header.payloadSize != payload.size() || header.payloadHash != fnv1a(payload))
+    {
+        Logger::debug("Stale cache entry: " + path.string());
+        return std::nullopt;
+    }
+
+    FlatFeature feature;
+    Reader reader(payload);
+    reader.readTable();
+    visitFields(feature, reader);
+    if (!reader.ok || !reader.atEnd() || !isConsistent(feature))
+    {
+        Logger::warn("Ignoring malformed cache entry: " + path.string());
+        return std::nullopt;
+    }
+    return feature;
+}
+
+void FeatureCache::store(std::string_view source, const FlatFeature& feature) const
+{
+    Writer writer;
+    visitFields(feature, writer);
+    const std::string payload = writer.bytes();
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = entryVersion();
+    header.contentHash = contentHash(source);
+    header.sourceSize = source.size();
+    header.payloadSize = payload.size();
+    header.payloadHash = fnv1a(payload);
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    const auto path = entryPath(source);
+    auto temporary = path;
+    // Files are loaded in parallel, and two of them may have the same content;
+    // every store writes its own temporary file, so neither can publish the
+    // other's half-written one.
+    static std::atomic<uint64_t> stores{ 0 };
+    temporary += ".tmp" + std::to_string(::getpid()) + "." + std::to_string(stores.fetch_add(1));
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!out)
+        {
+            Logger::warn("Could not write cache entry: " + temporary.string());
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        Logger::warn("Could not write cache entry: " + path.string());
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+} // namespace pep
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "FlatFeature.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace pep
+{
+
+// On-disk cache of parsed features. Each entry is the FlatFeature of one
+// source text, stored in a file named after the hash of that text. An entry is
+// only used if its format version, content hash, source size and payload
+// checksum all match and its indices are in bounds, so edited files, parser
+// upgrades and truncated or corrupted entries all fall back to parsing.
+class FeatureCache
+{
+public:
+    // Bump when the entry layout changes. The parser's own version
+    // (Parser::Version) is part of every entry as well.
+    static constexpr uint32_t FormatVersion = 2;
+
+    // The directory is created on the first store().
+    explicit FeatureCache(std::filesystem::path directory);
+
+    // The cached feature for `source`, or nothing on a miss.
+    std::optional<FlatFeature> load(std::string_view source) const;
+    // Writes the entry for `source`. The file is written next to its final
+    // name and renamed into place, so concurrent runs never see half an entry.
+    // Failing to write is not an error; the run just goes uncached.
+    void store(std::string_view source, const FlatFeature& feature) const;
+
+    static uint64_t contentHash(std::string_view source);
+    std::filesystem::path entryPath(std::string_view source) const;
+
+private:
+    std::filesystem::path m_directory;
+};
+
+} // namespace pep
@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "FlatFeature.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace pep
+{
+
+namespace
+{
+using Index = FlatFeature::Index;
+
+Index toIndex(size_t value)
+{
+    if (value >= FlatFeature::None)
+    {
+        throw std::length_error("Feature too large to flatten");
+    }
+    return static_cast<Index>(value);
+}
+
+class Flattener
+{
+public:
+    explicit Flattener(FlatFeature& flat) : m_flat(flat) {}
+
+    FlatFeature::Range tags(const std::pmr::vector<Symbol>& tags)
+    {
+        const FlatFeature::Range range{ toIndex(m_flat.tagText.size()), toIndex(tags.size()) };
+        m_flat.tagText.insert(m_flat.tagText.end(), tags.begin(), tags.end());
+        return range;
+    }
+
+    FlatFeature::Range steps(const std::pmr::vector<NodePtr<StepStatement>>& steps)
+    {
+        const FlatFeature::Range range{ toIndex(m_flat.stepType.size()), toIndex(steps.size()) };
+        for (const auto& step : steps)
+        {
+            m_flat.stepType.push_back(step->type);
+            m_flat.stepKeyword.push_back(step->keyword);
+
+            const FlatFeature::Range tokens{ toIndex(m_flat.tokenType.size()), toIndex(step->text.size()) };
+            bool hasPlaceholder = false;
+            for (const auto& token : step->text)
+            {
+                m_flat.tokenType.push_back(token.type);
+                m_flat.tokenText.push_back(intern(token.lexeme));
+                hasPlaceholder |= token.type == TokenType::Placeholder;
+            }
+            m_flat.stepTokens.push_back(tokens);
+
+            // Literal steps are joined once here so running them needs no work.
+            Symbol text;
+            if (!hasPlaceholder)
+            {
+                m_scratch.clear();
+                for (const auto& token : step->text)
+                {
+                    if (&token != &step->text.front())
+                        m_scratch.push_back(' ');
+                    m_scratch.append(token.lexeme);
+                }
+                text = intern(m_scratch);
+            }
+            m_flat.stepText.push_back(text);
+        }
+        return range;
+    }
+
+    FlatFeature::Range cells(const std::pmr::vector<std::string_view>& cells)
+    {
+        const FlatFeature::Range range{ toIndex(m_flat.cellText.size()), toIndex(cells.size()) };
+        for (const auto& cell : cells)
+            m_flat.cellText.push_back(intern(cell));
+        return range;
+    }
+
+    Index examples(const ExamplesStatement& examples)
+    {
+        const auto index = toIndex(m_flat.examplesHeaders.size());
+        m_flat.examplesHeaders.push_back(cells(examples.headers));
+        m_flat.examplesRows.push_back({ toIndex(m_flat.rowCells.size()), toIndex(examples.rows.size()) });
+        for (const auto& row : examples.rows)
+            m_flat.rowCells.push_back(cells(row));
+        return index;
+    }
+
+private:
+    FlatFeature& m_flat;
+    std::string m_scratch;
+};
+} // namespace
+
+FlatFeature FlatFeature::flatten(const FeatureStatement& feature)
+{
+    FlatFeature flat;
+    Flattener flattener(flat);
+
+    flat.name = intern(feature.name);
+    flat.tags = flattener.tags(feature.tags);
+    if (feature.background)
+    {
+        flat.hasBackground = true;
+        flat.background = flattener.steps(feature.background->steps);
+    }
+
+    const size_t scenarios = feature.scenarios.size() + feature.scenarioOutlines.size();
+    flat.scenarioName.reserve(scenarios);
+    flat.scenarioTags.reserve(scenarios);
+    flat.scenarioSteps.reserve(scenarios);
+    flat.scenarioOutline.reserve(scenarios);
+    flat.scenarioExamples.reserve(scenarios);
+
+    for (const auto& scenario : feature.scenarios)
+    {
+        flat.scenarioName.push_back(intern(scenario->name));
+        flat.scenarioTags.push_back(flattener.tags(scenario->tags));
+        flat.scenarioSteps.push_back(flattener.steps(scenario->steps));
+        flat.scenarioOutline.push_back(0);
+        flat.scenarioExamples.push_back(None);
+    }
+    for (const auto& outline : feature.scenarioOutlines)
+    {
+        flat.scenarioName.push_back(intern(outline->name));
+        flat.scenarioTags.push_back(flattener.tags(outline->tags));
+        flat.scenarioSteps.push_back(flattener.steps(outline->steps));
+        flat.scenarioOutline.push_back(1);
+        flat.scenarioExamples.push_back(outline->examples ? flattener.examples(*outline->examples) : None);
+    }
+    return flat;
+}
+
+} // namespace pep
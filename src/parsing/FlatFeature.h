@@ -0,0 +1,89 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "../Interner.h"
+#include "Statement.h"
+#include "Token.h"
+#include "pepino/types/types.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace pep
+{
+
+// A parsed feature laid out as flat arrays (structure of arrays). Scenarios,
+// steps, tokens, example rows and cells each live in one contiguous vector per
+// field and refer to each other with 32-bit indices; all text is interned, so
+// a step text or tag repeated across features is stored once and compared as
+// an integer. Running a feature walks these arrays front to back, and since
+// nothing holds a pointer the structure is straightforward to serialize.
+class FlatFeature
+{
+public:
+    using Index = uint32_t;
+    static constexpr Index None = UINT32_MAX;
+
+    // A run of consecutive elements in one of the arrays below.
+    struct Range
+    {
+        Index first = 0;
+        Index count = 0;
+        Index end() const { return first + count; }
+        bool operator==(const Range&) const = default;
+    };
+
+    static FlatFeature flatten(const FeatureStatement& feature);
+
+    // Feature
+    Symbol name;
+    Range tags;            // into tagText
+    Range background;      // into step arrays
+    bool hasBackground = false;
+
+    // Scenarios, plain scenarios first and then outlines, in source order.
+    std::vector<Symbol> scenarioName;
+    std::vector<Range> scenarioTags;      // into tagText
+    std::vector<Range> scenarioSteps;     // into step arrays
+    std::vector<uint8_t> scenarioOutline; // 1 for a Scenario Outline
+    std::vector<Index> scenarioExamples;  // into examples arrays, or None
+
+    // Steps
+    std::vector<types::StepType> stepType;
+    std::vector<Symbol> stepKeyword;
+    std::vector<Range> stepTokens; // into token arrays
+    // The step text with single spaces between words, or the empty symbol for
+    // steps that contain placeholders.
+    std::vector<Symbol> stepText;
+
+    // Step text tokens (string literals and placeholders)
+    std::vector<TokenType> tokenType;
+    std::vector<Symbol> tokenText;
+
+    // Examples tables
+    std::vector<Range> examplesHeaders; // into cellText
+    std::vector<Range> examplesRows;    // into rowCells
+
+    std::vector<Range> rowCells; // into cellText
+    std::vector<Symbol> cellText;
+
+    std::vector<Symbol> tagText;
+
+    Index scenarioCount() const { return static_cast<Index>(scenarioName.size()); }
+};
+
+} // namespace pep
@@ -0,0 +1,183 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "Keywords.h"
+
+namespace pep
+{
+
+namespace
+{
+// Keyword sets follow the Gherkin language definitions. Elided forms that are
+// glued to the next word (e.g. French "Lorsqu'") cannot be told apart by a
+// word-based lexer and are left out.
+constexpr Dialect English{ "en",
+                           {
+                               { "Feature", TokenType::Feature },
+                               { "Business Need", TokenType::Feature },
+                               { "Ability", TokenType::Feature },
+                               { "Rule", TokenType::Rule },
+                               { "Background", TokenType::Background },
+                               { "Scenario", TokenType::Scenario },
+                               { "Example", TokenType::Scenario },
+                               { "Scenario Outline", TokenType::ScenarioOutline },
+                               { "Scenario Template", TokenType::ScenarioOutline },
+                               // Historical single-word spelling accepted by earlier versions.
+                               { "ScenarioOutline", TokenType::ScenarioOutline },
+                               { "Examples", TokenType::Examples },
+                               { "Scenarios", TokenType::Examples },
+                               { "Given", TokenType::Given },
+                               { "When", TokenType::When },
+                               { "Then", TokenType::Then },
+                               { "And", TokenType::And },
+                               { "But", TokenType::But },
+                               { "*", TokenType::And },
+                           } };
+
+constexpr Dialect French{ "fr",
+                          {
+                              { "Fonctionnalité", TokenType::Feature },
+                              { "Règle", TokenType::Rule },
+                              { "Contexte", TokenType::Background },
+                              { "Scénario", TokenType::Scenario },
+                              { "Exemple", TokenType::Scenario },
+                              { "Plan du scénario", TokenType::ScenarioOutline },
+                              { "Plan du Scénario", TokenType::ScenarioOutline },
+                              { "Exemples", TokenType::Examples },
+                              { "Soit", TokenType::Given },
+                              { "Sachant que", TokenType::Given },
+                              { "Sachant", TokenType::Given },
+                              { "Etant donné que", TokenType::Given },
+                              { "Etant donné", TokenType::Given },
+                              { "Etant donnée", TokenType::Given },
+                              { "Etant donnés", TokenType::Given },
+                              { "Etant données", TokenType::Given },
+                              { "Étant donné que", TokenType::Given },
+                              { "Étant donné", TokenType::Given },
+                              { "Étant donnée", TokenType::Given },
+                              { "Étant donnés", TokenType::Given },
+                              { "Étant données", TokenType::Given },
+                              { "Quand", TokenType::When },
+                              { "Lorsque", TokenType::When },
+                              { "Alors", TokenType::Then },
+                              { "Donc", TokenType::Then },
+                              { "Et que", TokenType::And },
+                              { "Et", TokenType::And },
+                              { "Mais que", TokenType::But },
+                              { "Mais", TokenType::But },
+                              { "*", TokenType::And },
+                          } };
+
+constexpr Dialect German{ "de",
+                          {
+                              { "Funktionalität", TokenType::Feature },
+                              { "Funktion", TokenType::Feature },
+                              { "Regel", TokenType::Rule },
+                              { "Rule", TokenType::Rule },
+                              { "Grundlage", TokenType::Background },
+                              { "Hintergrund", TokenType::Background },
+                              { "Voraussetzungen", TokenType::Background },
+                              { "Vorbedingungen", TokenType::Background },
+                              { "Szenario", TokenType::Scenario },
+                              { "Beispiel", TokenType::Scenario },
+                              { "Szenariogrundriss", TokenType::ScenarioOutline },
+                              { "Szenarien", TokenType::ScenarioOutline },
+                              { "Beispiele", TokenType::Examples },
+                              { "Angenommen", TokenType::Given },
+                              { "Gegeben sei", TokenType::Given },
+                              { "Gegeben seien", TokenType::Given },
+                              { "Wenn", TokenType::When },
+                              { "Dann", TokenType::Then },
+                              { "Und", TokenType::And },
+                              { "Aber", TokenType::But },
+                              { "*", TokenType::And },
+                          } };
+
+constexpr Dialect Spanish{ "es",
+                           {
+                               { "Característica", TokenType::Feature },
+                               { "Necesidad del negocio", TokenType::Feature },
+                               { "Requisito", TokenType::Feature },
+                               { "Regla", TokenType::Rule },
+                               { "Regla de negocio", TokenType::Rule },
+                               { "Antecedentes", TokenType::Background },
+                               { "Escenario", TokenType::Scenario },
+                               { "Ejemplo", TokenType::Scenario },
+                               { "Esquema del escenario", TokenType::ScenarioOutline },
+                               { "Ejemplos", TokenType::Examples },
+                               { "Dado", TokenType::Given },
+                               { "Dada", TokenType::Given },
+                               { "Dados", TokenType::Given },
+                               { "Dadas", TokenType::Given },
+                               { "Cuando", TokenType::When },
+                               { "Entonces", TokenType::Then },
+                               { "Y", TokenType::And },
+                               { "E", TokenType::And },
+                               { "Pero", TokenType::But },
+                               { "*", TokenType::And },
+                           } };
+
+constexpr Dialect Portuguese{ "pt",
+                              {
+                                  { "Funcionalidade", TokenType::Feature },
+                                  { "Característica", TokenType::Feature },
+                                  { "Caracteristica", TokenType::Feature },
+                                  { "Regra", TokenType::Rule },
+                                  { "Contexto", TokenType::Background },
+                                  { "Cenário de Fundo", TokenType::Background },
+                                  { "Cenario de Fundo", TokenType::Background },
+                                  { "Fundo", TokenType::Background },
+                                  { "Cenário", TokenType::Scenario },
+                                  { "Cenario", TokenType::Scenario },
+                                  { "Exemplo", TokenType::Scenario },
+                                  { "Esquema do Cenário", TokenType::ScenarioOutline },
+                                  { "Esquema do Cenario", TokenType::ScenarioOutline },
+                                  { "Delineação do Cenário", TokenType::ScenarioOutline },
+                                  { "Delineacao do Cenario", TokenType::ScenarioOutline },
+                                  { "Exemplos", TokenType::Examples },
+                                  { "Cenários", TokenType::Examples },
+                                  { "Cenarios", TokenType::Examples },
+                                  { "Dado", TokenType::Given },
+                                  { "Dada", TokenType::Given },
+                                  { "Dados", TokenType::Given },
+                                  { "Dadas", TokenType::Given },
+                                  { "Quando", TokenType::When },
+                                  { "Então", TokenType::Then },
+                                  { "Entao", TokenType::Then },
+                                  { "E", TokenType::And },
+                                  { "Mas", TokenType::But },
+                                  { "*", TokenType::And },
+                              } };
+
+constexpr const Dialect* Dialects[] = { &English, &French, &German, &Spanish, &Portuguese };
+} // namespace
+
+const Dialect* Dialect::find(std::string_view code)
+{
+    for (const Dialect* dialect : Dialects)
+    {
+        if (dialect->code() == code)
+            return dialect;
+    }
+    return nullptr;
+}
+
+const Dialect& Dialect::english()
+{
+    return English;
+}
+
+} // namespace pep
@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "Token.h"
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace pep
+{
+
+// A keyword as written in a feature file. Multi-word keywords such as
+// "Scenario Outline" are a single phrase.
+struct KeywordPhrase
+{
+    std::string_view text;
+    TokenType type;
+};
+
+// The keywords of one Gherkin spoken language. Phrases are indexed by their
+// first word in a perfect hash table whose seed is searched for at compile
+// time, so classifying a word costs one hash and one compare.
+class Dialect
+{
+public:
+    static constexpr size_t MaxPhrases = 64;
+    static constexpr size_t TableSize = 128;
+
+    consteval Dialect(std::string_view code, std::initializer_list<KeywordPhrase> phrases)
+        : m_code(code)
+    {
+        if (phrases.size() > MaxPhrases)
+            throw std::logic_error("Too many keyword phrases");
+
+        // Group phrases by first word, longest phrase first, so the lexer can
+        // take the longest match.
+        for (const auto& phrase : phrases)
+        {
+            size_t at = m_count++;
+            while (at > 0 && comesBefore(phrase, m_phrases[at - 1]))
+            {
+                m_phrases[at] = m_phrases[at - 1];
+                --at;
+            }
+            m_phrases[at] = phrase;
+        }
+
+        for (m_seed = 0; !tryBuildTable(); ++m_seed)
+        {
+            if (m_seed > 100000)
+                throw std::logic_error("No perfect hash seed found for keyword table");
+        }
+    }
+
+    std::string_view code() const { return m_code; }
+
+    // Phrases whose first word is `word`, longest first. Empty if `word` does
+    // not start any keyword.
+    std::span<const KeywordPhrase> lookup(std::string_view word) const
+    {
+        const Slot& slot = m_slots[hash(word, m_seed) & (TableSize - 1)];
+        if (slot.count == 0 || slot.word != word)
+            return {};
+        return { m_phrases.data() + slot.first, slot.count };
+    }
+
+    // The dialect for a `# language:` code, or nullptr if it is not supported.
+    static const Dialect* find(std::string_view code);
+    static const Dialect& english();
+
+private:
+    struct Slot
+    {
+        std::string_view word;
+        uint8_t first = 0;
+        uint8_t count = 0;
+    };
+
+    static constexpr uint32_t hash(std::string_view word, uint32_t seed)
+    {
+        // FNV-1a with the seed folded into the offset basis.
+        uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+        for (char c : word)
+        {
+            h ^= static_cast<unsigned char>(c);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    static constexpr std::string_view firstWord(std::string_view text) { return text.substr(0, text.find(' ')); }
+
+    static constexpr bool comesBefore(const KeywordPhrase& a, const KeywordPhrase& b)
+    {
+        const auto wordA = firstWord(a.text);
+        const auto wordB = firstWord(b.text);
+        return wordA == wordB ? a.text.size() > b.text.size() : wordA < wordB;
+    }
+
+    constexpr bool tryBuildTable()
+    {
+        m_slots = {};
+        for (size_t i = 0; i < m_count;)
+        {
+            const auto word = firstWord(m_phrases[i].text);
+            size_t end = i;
+            while (end < m_count && firstWord(m_phrases[end].text) == word)
+                ++end;
+
+            Slot& slot = m_slots[hash(word, m_seed) & (TableSize - 1)];
+            if (slot.count != 0)
+                return false;
+            slot = { word, static_cast<uint8_t>(i), static_cast<uint8_t>(end - i) };
+            i = end;
+        }
+        return true;
+    }
+
+    std::string_view m_code;
+    std::array<KeywordPhrase, MaxPhrases> m_phrases{};
+    size_t m_count = 0;
+    std::array<Slot, TableSize> m_slots{};
+    uint32_t m_seed = 0;
+};
+
+} // namespace pep
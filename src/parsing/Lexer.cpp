@@ -17,6 +17,10 @@
 #include "Lexer.h"
 #include "../Logger.h"
 #include "Token.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 
 namespace pep
@@ -24,108 +28,147 @@ namespace pep
 
 namespace
 {
-TokenType keywordType(const std::string& lexeme)
+// Returns the language code of a "# language: xx" header line, or an empty view.
+std::string_view languageOf(std::string_view line)
 {
-    if (lexeme == "Feature")
-        return TokenType::Feature;
-    if (lexeme == "Background")
-        return TokenType::Background;
-    if (lexeme == "Scenario")
-        return TokenType::Scenario;
-    if (lexeme == "ScenarioOutline")
-        return TokenType::ScenarioOutline;
-    if (lexeme == "Examples")
-        return TokenType::Examples;
-    if (lexeme == "Given")
-        return TokenType::Given;
-    if (lexeme == "When")
-        return TokenType::When;
-    if (lexeme == "Then")
-        return TokenType::Then;
-    if (lexeme == "And")
-        return TokenType::And;
-    if (lexeme == "But")
-        return TokenType::But;
-    return TokenType::StringLiteral;
+    auto skipBlanks = [&line]()
+    {
+        while (!line.empty() && scan::isSpace(line.front()))
+            line.remove_prefix(1);
+    };
+    skipBlanks();
+    if (line.empty() || line.front() != '#')
+        return {};
+    line.remove_prefix(1);
+    skipBlanks();
+    constexpr std::string_view Language = "language";
+    if (!line.starts_with(Language))
+        return {};
+    line.remove_prefix(Language.size());
+    skipBlanks();
+    if (line.empty() || line.front() != ':')
+        return {};
+    line.remove_prefix(1);
+    skipBlanks();
+    size_t end = 0;
+    while (end < line.size() && !scan::isSpace(line[end]))
+        ++end;
+    return line.substr(0, end);
+}
+
+bool endsWord(char c)
+{
+    return scan::isSpace(c) || c == '<' || c == '>' || c == ':';
 }
 } // namespace
 
-Lexer::Lexer(const std::string& source) : m_source(source)
+Lexer::Lexer(std::string_view source) : m_source(source), m_scanner(source), m_dialect(&Dialect::english())
 {
+    // A "# language:" header may appear among the comments and blank lines
+    // that precede the first statement.
+    for (size_t pos = 0; pos < m_source.size();)
+    {
+        const size_t eol = std::min(m_source.find('\n', pos), m_source.size());
+        const auto line = m_source.substr(pos, eol - pos);
+        const auto first = line.find_first_not_of(" \t\r\v\f");
+        if (first != std::string_view::npos && line[first] != '#')
+            break;
+        if (const auto code = languageOf(line); !code.empty())
+        {
+            m_dialect = Dialect::find(code);
+            if (!m_dialect)
+                throw std::runtime_error("Unsupported language: " + std::string(code));
+            break;
+        }
+        pos = eol + 1;
+    }
 }
 
 std::vector<Token> Lexer::tokenize()
 {
     std::vector<Token> tokens;
+    do
+    {
+        tokens.push_back(next());
+    } while (tokens.back().type != TokenType::EndOfFile);
+    Logger::debug("Tokenized " + std::to_string(tokens.size()) + " tokens");
+    return tokens;
+}
+
+Token Lexer::next()
+{
     while (!isAtEnd())
     {
+        const bool atLineStart = m_atLineStart;
+        m_atLineStart = false;
         char c = advance();
         if (c == '\n')
         {
-            tokens.push_back({TokenType::EOL, "\\n", m_line++});
+            m_atLineStart = true;
+            return {TokenType::EOL, "\\n", m_line++};
+        }
+        else if (scan::isSpace(c))
+        {
+            // Skip the whole run of blanks at once.
+            m_atLineStart = atLineStart;
+            m_current = m_scanner.skipBlanks(m_current);
         }
-        else if (std::isspace(c))
+        else if (c == '#' && atLineStart)
         {
-            continue;
+            // Comment line: skip to (but not past) the newline.
+            m_current = std::min(m_source.find('\n', m_current), m_source.size());
         }
         else if (c == '@')
         {
             // Parse a tag (e.g., "@smoke")
-            std::string tag(1, c);
-            while (!isAtEnd() && !std::isspace(peek()))
-            {
-                tag.push_back(advance());
-            }
-            tokens.push_back({TokenType::Tag, tag, m_line});
+            const size_t start = m_current - 1;
+            m_current = m_scanner.findSpace(m_current);
+            return {TokenType::Tag, m_source.substr(start, m_current - start), m_line};
         }
         else if (c == ':')
         {
-            tokens.push_back({TokenType::Colon, ":", m_line});
+            return {TokenType::Colon, ":", m_line};
         }
         else if (c == '|')
         {
-            tokens.push_back({TokenType::Pipe, "|", m_line});
+            return {TokenType::Pipe, "|", m_line};
         }
         else if (c == '<')
         {
-            tokens.push_back({TokenType::LeftAngle, "<", m_line});
+            return {TokenType::LeftAngle, "<", m_line};
         }
         else if (c == '>')
         {
-            tokens.push_back({TokenType::RightAngle, ">", m_line});
+            return {TokenType::RightAngle, ">", m_line};
         }
         else
         {
-            std::string literal;
-            literal.push_back(c);
-            while (!isAtEnd() && !std::isspace(peek()) && (peek() != '>') &&
-                   (peek() != '<') && (peek() != ':'))
-            {
-                literal.push_back(advance());
-            }
-            auto type = keywordType(literal);
-            if (type == TokenType::Scenario)
-            {
-                // Check if next word is "Outline"
-                constexpr std::string_view Outline = " Outline";
-                if (m_current + Outline.size() < m_source.size() &&
-                    m_source.substr(m_current, Outline.size()) == Outline)
-                {
-                    literal += Outline.data();
-                    m_current += Outline.size();
-                    type = TokenType::ScenarioOutline;
-                }
-            }
-            tokens.push_back({type, literal, m_line});
+            const size_t start = m_current - 1;
+            m_current = m_scanner.findWordEnd(m_current);
+            // Keywords only open a line; anywhere else they are plain words.
+            const auto type = atLineStart ? keyword(start) : TokenType::StringLiteral;
+            return {type, m_source.substr(start, m_current - start), m_line};
         }
     }
-    tokens.push_back({TokenType::EndOfFile, "", m_line});
-    Logger::debug("Tokens:");
-    for (auto& token : tokens)
+    return {TokenType::EndOfFile, "", m_line};
+}
+
+TokenType Lexer::keyword(size_t start)
+{
+    const auto word = m_source.substr(start, m_current - start);
+    for (const auto& phrase : m_dialect->lookup(word))
     {
-        Logger::debug(tokenAsString(token));
+        // Multi-word phrases ("Scenario Outline") must continue verbatim in the
+        // source and end on a word boundary; the lexeme then covers all words.
+        const auto rest = phrase.text.substr(word.size());
+        const size_t end = m_current + rest.size();
+        if (m_source.substr(m_current, rest.size()) == rest && (end >= m_source.size() || endsWord(m_source[end])))
+        {
+            m_current = end;
+            return phrase.type;
+        }
     }
-    return tokens;
+    return TokenType::StringLiteral;
 }
 
 char Lexer::peek() const
@@ -145,10 +188,4 @@ bool Lexer::isAtEnd() const
     return m_current >= m_source.size();
 }
 
-void Lexer::addToken(TokenType type, const std::string& lexeme,
-                     std::vector<Token>& tokens)
-{
-    tokens.push_back({type, lexeme, m_line});
-}
-
 } // namespace pep
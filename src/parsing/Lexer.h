@@ -15,27 +15,46 @@
  *******************************************************************************/
 #pragma once
 
+#include "Keywords.h"
+#include "Scanner.h"
 #include "Token.h"
-#include <string>
+#include "TokenStream.h"
+#include <string_view>
 #include <vector>
 
 namespace pep
 {
-class Lexer
+// The lexer never copies the source: every token it emits views `source`
+// directly, so the caller keeps the buffer alive for as long as the tokens
+// (or the AST built from them) are in use.
+//
+// Keywords are recognised in the dialect named by a "# language:" header
+// (English by default), and only as the first word of a line. Lines starting
+// with '#' are comments.
+//
+// Tokens are produced on demand through next(), so the Parser can pull them
+// one at a time; tokenize() materializes the whole stream at once.
+class Lexer : public TokenStream
 {
 public:
-    explicit Lexer(const std::string& source);
+    explicit Lexer(std::string_view source);
     std::vector<Token> tokenize();
+    Token next() override;
 
 private:
-    std::string m_source;
+    std::string_view m_source;
+    scan::Scanner m_scanner;
+    const Dialect* m_dialect;
     size_t m_current = 0;
     int m_line = 1;
+    bool m_atLineStart = true;
 
     char peek() const;
     char advance();
     bool isAtEnd() const;
-    void addToken(TokenType type, const std::string& lexeme, std::vector<Token>& tokens);
+    // Classifies the word at [start, m_current), consuming the remaining
+    // words of a multi-word keyword.
+    TokenType keyword(size_t start);
 };
 
 } // namespace pep
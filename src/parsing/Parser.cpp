@@ -19,13 +19,39 @@
 #include "Token.h"
 
 #include <memory>
-#include <numeric>
 #include <vector>
 
 namespace pep
 {
 
-Parser::Parser(const std::vector<Token>& tokens) : m_tokens(tokens)
+namespace
+{
+types::StepType stepType(TokenType type)
+{
+    switch (type)
+    {
+    case TokenType::Given:
+        return types::StepType::Given;
+    case TokenType::When:
+        return types::StepType::When;
+    case TokenType::Then:
+        return types::StepType::Then;
+    case TokenType::But:
+        return types::StepType::But;
+    default:
+        return types::StepType::And;
+    }
+}
+} // namespace
+
+Parser::Parser(TokenStream& tokens, std::pmr::memory_resource* resource)
+    : m_stream(tokens), m_current(m_stream.next()), m_resource(resource)
+{
+}
+
+Parser::Parser(const std::vector<Token>& tokens, std::pmr::memory_resource* resource)
+    : m_ownedStream(std::make_unique<TokenVectorStream>(tokens)), m_stream(*m_ownedStream),
+      m_current(m_stream.next()), m_resource(resource)
 {
 }
 
@@ -36,18 +62,21 @@ bool Parser::isAtEnd() const
 
 const Token& Parser::peek() const
 {
-    return m_tokens[m_current];
+    return m_current;
 }
 
 const Token& Parser::previous() const
 {
-    return m_tokens[m_current - 1];
+    return m_previous;
 }
 
 const Token& Parser::advance()
 {
     if (!isAtEnd())
-        m_current++;
+    {
+        m_previous = m_current;
+        m_current = m_stream.next();
+    }
     return previous();
 }
 
@@ -67,85 +96,94 @@ void Parser::advanceEmptyLines()
     }
 }
 
-std::string Parser::consumeLiteralUntilEOL()
+void Parser::consumeLiteralUntilEOL(std::pmr::string& literal)
 {
-    std::vector<Token> text;
-
-    while (!isAtEnd() && peek().type != TokenType::EOL)
+    literal.clear();
+    for (bool first = true; !isAtEnd() && peek().type != TokenType::EOL; first = false)
     {
-        text.push_back(advance());
-    }
-    std::string literal = std::accumulate(
-        std::next(text.begin()), text.end(), text.front().lexeme,
-        [](const std::string& a, const Token& b) {
-            if (b.type != TokenType::StringLiteral)
+        const Token& token = advance();
+        if (!first)
+        {
+            if (token.type != TokenType::StringLiteral)
             {
-                throw std::runtime_error("Expected StringLiteral, got: " +
-                                         tokenAsString(b));
+                throw std::runtime_error("Expected StringLiteral, got: " + tokenAsString(token));
             }
-            return a + " " + b.lexeme;
-        });
-    return literal;
+            literal.push_back(' ');
+        }
+        literal.append(token.lexeme);
+    }
 }
 
-const Token& Parser::consume(TokenType type, const std::string& message)
+const Token& Parser::consume(TokenType type, std::string_view message)
 {
     if (peek().type == type)
     {
         return advance();
     }
     Logger::error(
-        "Expected token of type: " + tokenAsString(Token{.type = type}) +
+        "Expected token of type: " + tokenAsString(Token{ type, {}, 0 }) +
         ", got: " + tokenAsString(peek()));
-    throw std::runtime_error(message + " at line " +
+    throw std::runtime_error(std::string(message) + " at line " +
                              std::to_string(peek().line));
 }
 
-std::vector<std::string> Parser::parseTags()
+std::pmr::vector<Symbol> Parser::parseTags()
 {
-    std::vector<std::string> tags;
+    std::pmr::vector<Symbol> tags(allocator());
     while (match(TokenType::Tag))
     {
-        tags.push_back(previous().lexeme);
+        tags.push_back(intern(previous().lexeme));
     }
     return tags;
 }
 
 std::unique_ptr<FeatureStatement> Parser::parseFeature()
 {
-    auto feature = std::make_unique<FeatureStatement>();
+    auto feature = std::make_unique<FeatureStatement>(m_resource);
+    m_nodeResource = feature->get_allocator().resource();
     advanceEmptyLines();
     feature->tags = parseTags();
     advanceEmptyLines();
 
     consume(TokenType::Feature, "Expected 'Feature' keyword");
-    if (previous().lexeme != "Feature")
-    {
-        throw std::runtime_error("Expected 'Feature' keyword, got " +
-                                 previous().lexeme);
-    }
     consume(TokenType::Colon, "Expected ':' after 'Feature'");
-    feature->name = consumeLiteralUntilEOL();
-
-    // Ignore description lines.
-    Logger::debug("Advancing empty lines after feature name");
-    advanceEmptyLines();
-    while (!isAtEnd() && peek().type == TokenType::StringLiteral)
-    {
-        auto tok = advance();
-        advanceEmptyLines();
-        Logger::debug("Ignoring description line: " + tok.lexeme);
-    }
-    Logger::debug("Finished parsing feature name and description");
+    consumeLiteralUntilEOL(feature->name);
+    skipDescription();
 
     // Parse children: background, scenarios, and scenario outlines.
-    std::vector<std::string> nextTags;
+    std::pmr::vector<Symbol> nextTags(allocator());
+    bool inRule = false;
     while (!isAtEnd())
     {
         if (match(TokenType::Background))
         {
+            // A Rule's scenarios are the feature's scenarios, so a Background
+            // of the Rule would apply to all of them; refuse rather than run
+            // steps where the author did not put them.
+            if (inRule)
+            {
+                throw std::runtime_error("A Background inside a Rule is not supported at line " +
+                                         std::to_string(previous().line));
+            }
+            if (feature->background)
+            {
+                throw std::runtime_error("A Feature can have only one Background at line " +
+                                         std::to_string(previous().line));
+            }
             feature->background = parseBackgroundStatement();
         }
+        else if (match(TokenType::Rule))
+        {
+            // Rules only group scenarios; their children are parsed as
+            // children of the feature. A Rule lasts until the next one or
+            // the end of the feature.
+            inRule = true;
+            consume(TokenType::Colon, "Expected ':' after 'Rule'");
+            std::pmr::string rule(allocator());
+            consumeLiteralUntilEOL(rule);
+            Logger::debug("Entering rule: " + std::string(rule));
+            skipDescription();
+        }
         else if (match(TokenType::Scenario))
         {
             auto scenario = parseScenarioStatement();
@@ -174,22 +212,34 @@ std::unique_ptr<FeatureStatement> Parser::parseFeature()
             Logger::debug("Storing tag: ");
             for (auto& tag : nextTags)
             {
-                Logger::debug(tag);
+                Logger::debug(std::string(tag.view()));
             }
         }
         else
         {
             // Skip unknown tokens - TODO throw here.
-            Logger::warn("Skipping unknown token: " + peek().lexeme);
+            Logger::warn("Skipping unknown token: " + std::string(peek().lexeme));
             advance();
         }
     }
     return feature;
 }
 
-std::unique_ptr<BackgroundStatement> Parser::parseBackgroundStatement()
+void Parser::skipDescription()
+{
+    // Ignore description lines.
+    advanceEmptyLines();
+    while (!isAtEnd() && peek().type == TokenType::StringLiteral)
+    {
+        auto tok = advance();
+        advanceEmptyLines();
+        Logger::debug("Ignoring description line: " + std::string(tok.lexeme));
+    }
+}
+
+NodePtr<BackgroundStatement> Parser::parseBackgroundStatement()
 {
-    auto background = std::make_unique<BackgroundStatement>();
+    auto background = make<BackgroundStatement>();
     consume(TokenType::Colon, "Expected ':' after 'Background'");
     // Parse steps until a new keyword or EOF.
     advanceEmptyLines();
@@ -200,13 +250,13 @@ std::unique_ptr<BackgroundStatement> Parser::parseBackgroundStatement()
     return background;
 }
 
-std::unique_ptr<ScenarioStatement> Parser::parseScenarioStatement()
+NodePtr<ScenarioStatement> Parser::parseScenarioStatement()
 {
-    auto scenario = std::make_unique<ScenarioStatement>();
+    auto scenario = make<ScenarioStatement>();
     // A scenario might have preceding tags.
     // scenario->tags = parseTags();
     consume(TokenType::Colon, "Expected ':' after 'Scenario'");
-    scenario->name = consumeLiteralUntilEOL();
+    consumeLiteralUntilEOL(scenario->name);
     advanceEmptyLines();
     while (!isAtEnd() && isStep(peek().type))
     {
@@ -215,13 +265,12 @@ std::unique_ptr<ScenarioStatement> Parser::parseScenarioStatement()
     return scenario;
 }
 
-std::unique_ptr<ScenarioOutlineStatement> Parser::
-    parseScenarioOutlineStatement()
+NodePtr<ScenarioOutlineStatement> Parser::parseScenarioOutlineStatement()
 {
-    auto outline = std::make_unique<ScenarioOutlineStatement>();
+    auto outline = make<ScenarioOutlineStatement>();
     // outline->tags = parseTags();
     consume(TokenType::Colon, "Expected ':' after 'ScenarioOutline'");
-    outline->name = consumeLiteralUntilEOL();
+    consumeLiteralUntilEOL(outline->name);
     advanceEmptyLines();
     while (!isAtEnd() && isStep(peek().type))
     {
@@ -235,9 +284,9 @@ std::unique_ptr<ScenarioOutlineStatement> Parser::
     return outline;
 }
 
-std::vector<std::string> Parser::parseTableRow()
+std::pmr::vector<std::string_view> Parser::parseTableRow()
 {
-    std::vector<std::string> row;
+    std::pmr::vector<std::string_view> row(allocator());
     // Each row must start with a Pipe.
     consume(TokenType::Pipe, "Expected '|' at start of examples table row");
 
@@ -252,12 +301,11 @@ std::vector<std::string> Parser::parseTableRow()
         }
         if (peek().type == TokenType::StringLiteral)
         {
-            Logger::debug("Cell found: " + peek().lexeme);
             row.push_back(advance().lexeme);
         }
         else
         {
-            Logger::warn("Unexpected token in table row: " + peek().lexeme);
+            Logger::warn("Unexpected token in table row: " + std::string(peek().lexeme));
             break;
         }
         if (peek().type == TokenType::Pipe)
@@ -268,7 +316,7 @@ std::vector<std::string> Parser::parseTableRow()
         {
             // If we don't find a pipe, we should break out of the loop.
             Logger::warn("Expected '|' after cell value, found: " +
-                         peek().lexeme);
+                         std::string(peek().lexeme));
             break;
         }
     }
@@ -283,9 +331,9 @@ std::vector<std::string> Parser::parseTableRow()
 //   | value1  | value2  | ... |
 //   | value3  | value4  | ... |
 // Returns an ExamplesStatement AST node.
-std::unique_ptr<ExamplesStatement> Parser::parseExamplesStatement()
+NodePtr<ExamplesStatement> Parser::parseExamplesStatement()
 {
-    auto examples = std::make_unique<ExamplesStatement>();
+    auto examples = make<ExamplesStatement>();
 
     consume(TokenType::Colon, "Expected ':' after 'Examples'");
 
@@ -317,21 +365,22 @@ std::unique_ptr<ExamplesStatement> Parser::parseExamplesStatement()
         // Only add non-empty rows.
         if (!row.empty())
         {
-            examples->rows.push_back(row);
+            examples->rows.push_back(std::move(row));
         }
     }
     advanceEmptyLines();
     return examples;
 }
 
-std::unique_ptr<StepStatement> Parser::parseStepStatement()
+NodePtr<StepStatement> Parser::parseStepStatement()
 {
-    auto step = std::make_unique<StepStatement>();
+    auto step = make<StepStatement>();
     if (!isStep(peek().type))
     {
         throw std::runtime_error("Expected a step keyword");
     }
-    step->keyword = advance().lexeme;
+    step->type = stepType(peek().type);
+    step->keyword = intern(advance().lexeme);
 
     // Consume the text in this  line. Check for <variable> placeholders.
     while (!isAtEnd() && peek().type != TokenType::EOL)
@@ -348,11 +397,10 @@ std::unique_ptr<StepStatement> Parser::parseStepStatement()
                     .lexeme;
             consume(TokenType::RightAngle, "Expected '>' after variable name");
             step->text.push_back({TokenType::Placeholder, var, peek().line});
-            step->variables[var] = ""; // Store the variable name.
         }
         else
         {
-            Logger::warn("Unexpected token in step text: " + peek().lexeme);
+            Logger::warn("Unexpected token in step text: " + std::string(peek().lexeme));
             break;
         }
     }
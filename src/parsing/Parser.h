@@ -17,41 +17,65 @@
 
 #include "Statement.h"
 #include "Token.h"
+#include "TokenStream.h"
 
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace pep
 {
 
+// Recursive-descent parser for feature files. Tokens are pulled from the
+// stream one at a time, so only the previous and the current token are held.
+// The tree is allocated from `resource` if one is given, otherwise from an
+// arena owned by the returned FeatureStatement.
 class Parser
 {
 public:
-    explicit Parser(const std::vector<Token>& tokens);
+    // Bump whenever the same input would parse to a different tree; cached
+    // parse results from other versions are then ignored.
+    static constexpr uint32_t Version = 1;
+
+    explicit Parser(TokenStream& tokens, std::pmr::memory_resource* resource = nullptr);
+    explicit Parser(const std::vector<Token>& tokens, std::pmr::memory_resource* resource = nullptr);
     std::unique_ptr<FeatureStatement> parseFeature();
 
 private:
-    std::unique_ptr<FeatureStatement> parseFeatureStatement();
-    std::unique_ptr<BackgroundStatement> parseBackgroundStatement();
-    std::unique_ptr<ScenarioStatement> parseScenarioStatement();
-    std::unique_ptr<ScenarioOutlineStatement> parseScenarioOutlineStatement();
-    std::unique_ptr<ExamplesStatement> parseExamplesStatement();
-    std::unique_ptr<StepStatement> parseStepStatement();
+    NodePtr<BackgroundStatement> parseBackgroundStatement();
+    NodePtr<ScenarioStatement> parseScenarioStatement();
+    NodePtr<ScenarioOutlineStatement> parseScenarioOutlineStatement();
+    NodePtr<ExamplesStatement> parseExamplesStatement();
+    NodePtr<StepStatement> parseStepStatement();
+
+    // Allocates a node from the feature's resource.
+    template <typename T> NodePtr<T> make()
+    {
+        return NodePtr<T>(allocator().new_object<T>(), { m_nodeResource });
+    }
+    AstAllocator allocator() const { return AstAllocator(m_nodeResource); }
 
     bool isAtEnd() const;
     const Token& peek() const;
     const Token& previous() const;
     const Token& advance();
     void advanceEmptyLines();
-    std::string consumeLiteralUntilEOL();
+    void skipDescription();
+    void consumeLiteralUntilEOL(std::pmr::string& literal);
     bool match(TokenType type);
-    const Token& consume(TokenType type, const std::string& message);
-    std::vector<std::string> parseTags();
-    std::vector<std::string> parseTableRow();
+    const Token& consume(TokenType type, std::string_view message);
+    std::pmr::vector<Symbol> parseTags();
+    std::pmr::vector<std::string_view> parseTableRow();
 
-    const std::vector<Token>& m_tokens;
-    size_t m_current = 0;
+    std::unique_ptr<TokenStream> m_ownedStream; // Set when parsing a token vector
+    TokenStream& m_stream;
+    Token m_previous{ TokenType::EndOfFile, "", 0 };
+    Token m_current;
+    std::pmr::memory_resource* m_resource;
+    std::pmr::memory_resource* m_nodeResource = nullptr; // The feature's resource, set when parsing starts
 };
 
 } // namespace pep
@@ -0,0 +1,207 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "Scanner.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PEPINO_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace pep::scan
+{
+
+namespace
+{
+
+// Kernels classify exactly BlockSize bytes; classify() pads short tails.
+using Kernel = BlockMasks (*)(const char* data);
+
+BlockMasks classifyScalar(const char* data)
+{
+    BlockMasks masks{};
+    for (size_t i = 0; i < BlockSize; ++i)
+    {
+        const char c = data[i];
+        const uint64_t bit = uint64_t{ 1 } << i;
+        if (isSpace(c))
+        {
+            masks.space |= bit;
+            masks.wordEnd |= bit;
+            if (c != '\n')
+                masks.blank |= bit;
+        }
+        else if (c == '<' || c == '>' || c == ':')
+        {
+            masks.wordEnd |= bit;
+        }
+    }
+    return masks;
+}
+
+#ifdef PEPINO_SCAN_X86
+
+// Whitespace is ' ' or a byte in ['\t', '\r']; the range test is done as an
+// unsigned compare through min_epu8 since SSE2/AVX2 only have signed ones.
+__attribute__((target("sse2"))) BlockMasks classifySse2(const char* data)
+{
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8(4);
+    BlockMasks masks{};
+    for (size_t i = 0; i < BlockSize; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i shifted = _mm_sub_epi8(v, tab);
+        const __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(shifted, four), shifted);
+        const __m128i space = _mm_or_si128(inRange, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+        __m128i wordEnd = _mm_or_si128(space, _mm_cmpeq_epi8(v, _mm_set1_epi8('<')));
+        wordEnd = _mm_or_si128(wordEnd, _mm_cmpeq_epi8(v, _mm_set1_epi8('>')));
+        wordEnd = _mm_or_si128(wordEnd, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+        const __m128i blank = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), space);
+
+        masks.space |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(space))) << i;
+        masks.wordEnd |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(wordEnd))) << i;
+        masks.blank |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(blank))) << i;
+    }
+    return masks;
+}
+
+__attribute__((target("avx2"))) BlockMasks classifyAvx2(const char* data)
+{
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8(4);
+    BlockMasks masks{};
+    for (size_t i = 0; i < BlockSize; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i shifted = _mm256_sub_epi8(v, tab);
+        const __m256i inRange = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, four), shifted);
+        const __m256i space = _mm256_or_si256(inRange, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+        __m256i wordEnd = _mm256_or_si256(space, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')));
+        wordEnd = _mm256_or_si256(wordEnd, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')));
+        wordEnd = _mm256_or_si256(wordEnd, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')));
+        const __m256i blank = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), space);
+
+        masks.space |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(space))) << i;
+        masks.wordEnd |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(wordEnd))) << i;
+        masks.blank |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(blank))) << i;
+    }
+    return masks;
+}
+
+#endif // PEPINO_SCAN_X86
+
+struct Kernels
+{
+    Isa isa;
+    Kernel classify;
+};
+
+constexpr Kernels ScalarKernels{ Isa::Scalar, classifyScalar };
+#ifdef PEPINO_SCAN_X86
+constexpr Kernels Sse2Kernels{ Isa::Sse2, classifySse2 };
+constexpr Kernels Avx2Kernels{ Isa::Avx2, classifyAvx2 };
+#endif
+
+const Kernels* kernelsFor(Isa isa)
+{
+    switch (isa)
+    {
+#ifdef PEPINO_SCAN_X86
+    case Isa::Avx2:
+        return __builtin_cpu_supports("avx2") ? &Avx2Kernels : nullptr;
+    case Isa::Sse2:
+        return __builtin_cpu_supports("sse2") ? &Sse2Kernels : nullptr;
+#endif
+    case Isa::Scalar:
+        return &ScalarKernels;
+    default:
+        return nullptr;
+    }
+}
+
+const Kernels* detectKernels()
+{
+    for (Isa isa : { Isa::Avx2, Isa::Sse2 })
+    {
+        if (const Kernels* kernels = kernelsFor(isa))
+            return kernels;
+    }
+    return &ScalarKernels;
+}
+
+const Kernels*& active()
+{
+    static const Kernels* kernels = detectKernels();
+    return kernels;
+}
+
+} // namespace
+
+BlockMasks classify(const char* data, size_t size)
+{
+    if (size >= BlockSize)
+        return active()->classify(data);
+
+    // Pad the tail with spaces, then fix up the bits past the end.
+    char padded[BlockSize];
+    std::memset(padded, ' ', BlockSize);
+    std::memcpy(padded, data, size);
+    BlockMasks masks = active()->classify(padded);
+    const uint64_t valid = (uint64_t{ 1 } << size) - 1;
+    masks.space |= ~valid;
+    masks.wordEnd |= ~valid;
+    masks.blank &= valid;
+    return masks;
+}
+
+Isa activeIsa()
+{
+    return active()->isa;
+}
+
+bool isSupported(Isa isa)
+{
+    return kernelsFor(isa) != nullptr;
+}
+
+bool setIsa(Isa isa)
+{
+    const Kernels* kernels = kernelsFor(isa);
+    if (!kernels)
+        return false;
+    active() = kernels;
+    return true;
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::Sse2:
+        return "sse2";
+    case Isa::Avx2:
+        return "avx2";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace pep::scan
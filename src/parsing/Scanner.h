@@ -0,0 +1,115 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Byte-class scanning used by the Lexer. The source is classified 64 bytes at a
+// time into bitmasks (one bit per byte), so finding the end of a word or a run
+// of blanks is a shift and a count-trailing-zeros instead of a per-character
+// loop. Classification has a scalar version and, on x86, SSE2 and AVX2 versions
+// that test 16 or 32 bytes per instruction; the widest one the CPU supports is
+// picked at runtime and all of them produce identical masks.
+namespace pep::scan
+{
+
+enum class Isa
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Same set as std::isspace in the "C" locale: ' ', '\t', '\n', '\v', '\f', '\r'.
+inline bool isSpace(char c)
+{
+    const auto u = static_cast<unsigned char>(c);
+    return u == ' ' || static_cast<unsigned char>(u - '\t') < 5;
+}
+
+constexpr size_t BlockSize = 64;
+
+// Bit i describes byte i of a block. Bits past the end of the source are set in
+// `space` and `wordEnd` and clear in `blank`, so every search stops there.
+struct BlockMasks
+{
+    uint64_t space;   // whitespace
+    uint64_t wordEnd; // whitespace, '<', '>' or ':'
+    uint64_t blank;   // whitespace other than '\n'
+};
+
+// Classifies up to BlockSize bytes starting at `data` with the active
+// instruction set.
+BlockMasks classify(const char* data, size_t size);
+
+// Walks a source buffer, classifying one block at a time on demand.
+class Scanner
+{
+public:
+    explicit Scanner(std::string_view source) : m_source(source) {}
+
+    // Index of the first whitespace byte at or after `pos`, or source.size().
+    size_t findSpace(size_t pos) { return find(pos, &BlockMasks::space, false); }
+
+    // Index of the first byte at or after `pos` that ends a word: whitespace,
+    // '<', '>' or ':'. Returns source.size() if there is none.
+    size_t findWordEnd(size_t pos) { return find(pos, &BlockMasks::wordEnd, false); }
+
+    // Index of the first byte at or after `pos` that is not whitespace, treating
+    // '\n' as significant (it is never skipped). Returns source.size() if none.
+    size_t skipBlanks(size_t pos) { return find(pos, &BlockMasks::blank, true); }
+
+private:
+    size_t find(size_t pos, uint64_t BlockMasks::*mask, bool invert)
+    {
+        while (pos < m_source.size())
+        {
+            const size_t base = pos & ~(BlockSize - 1);
+            if (base != m_base)
+            {
+                m_masks = classify(m_source.data() + base, std::min(BlockSize, m_source.size() - base));
+                m_base = base;
+            }
+            uint64_t bits = m_masks.*mask;
+            if (invert)
+                bits = ~bits;
+            bits >>= pos - base;
+            if (bits != 0)
+                return std::min(pos + static_cast<size_t>(__builtin_ctzll(bits)), m_source.size());
+            pos = base + BlockSize;
+        }
+        return m_source.size();
+    }
+
+    std::string_view m_source;
+    size_t m_base = static_cast<size_t>(-1);
+    BlockMasks m_masks{};
+};
+
+// The instruction set currently used for classification.
+Isa activeIsa();
+// Whether this build and CPU can run `isa`.
+bool isSupported(Isa isa);
+// Forces a particular instruction set (for tests and benchmarks). Not
+// thread-safe; call it before lexing starts. Returns false if unsupported.
+bool setIsa(Isa isa);
+
+const char* isaName(Isa isa);
+
+} // namespace pep::scan
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "SourceFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pep
+{
+
+namespace
+{
+// Closes the descriptor on every path out of SourceFile::open.
+struct FileDescriptor
+{
+    int fd;
+    bool owned;
+    ~FileDescriptor()
+    {
+        if (owned && fd >= 0)
+            ::close(fd);
+    }
+};
+
+std::string readAll(int fd, const std::string& path)
+{
+    std::string text;
+    char chunk[64 * 1024];
+    for (;;)
+    {
+        const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n == 0)
+            break;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Could not read file: " + path + " (" + std::strerror(errno) + ")");
+        }
+        text.append(chunk, static_cast<size_t>(n));
+    }
+    return text;
+}
+} // namespace
+
+std::shared_ptr<const SourceFile> SourceFile::open(const std::string& path)
+{
+    const bool isStdin = path == "-";
+    FileDescriptor file{ isStdin ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY | O_CLOEXEC), !isStdin };
+    if (file.fd < 0)
+    {
+        throw std::runtime_error("Could not open file: " + path);
+    }
+
+    std::shared_ptr<SourceFile> source(new SourceFile());
+    source->m_path = path;
+
+    struct stat info{};
+    if (::fstat(file.fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        const auto size = static_cast<size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            // The lexer walks the file front to back exactly once.
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            source->m_data = static_cast<const char*>(mapping);
+            source->m_size = size;
+            source->m_mapped = true;
+            return source;
+        }
+    }
+
+    // Pipes, stdin, empty or unmappable files.
+    source->m_buffer = readAll(file.fd, path);
+    source->m_data = source->m_buffer.data();
+    source->m_size = source->m_buffer.size();
+    return source;
+}
+
+std::shared_ptr<const SourceFile> SourceFile::fromString(std::string text)
+{
+    std::shared_ptr<SourceFile> source(new SourceFile());
+    source->m_buffer = std::move(text);
+    source->m_data = source->m_buffer.data();
+    source->m_size = source->m_buffer.size();
+    return source;
+}
+
+SourceFile::~SourceFile()
+{
+    if (m_mapped)
+        ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+} // namespace pep
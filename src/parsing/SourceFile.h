@@ -0,0 +1,59 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pep
+{
+
+// The text of a feature file. Regular files are memory-mapped read-only, so
+// loading costs no copy and pages are only read in as the lexer reaches them;
+// pipes, character devices and stdin ("-") are read into an owned buffer.
+// Tokens and some AST nodes (example cells) view this buffer, so it must
+// outlive them; whoever parses keeps it alive. TestController::loadFeature
+// releases it once the feature is flattened, as FlatFeature::flatten copies
+// or interns every text it keeps.
+class SourceFile
+{
+public:
+    // Throws std::runtime_error if the file cannot be opened or read.
+    static std::shared_ptr<const SourceFile> open(const std::string& path);
+    // Wraps text that is already in memory (tests and generated features).
+    static std::shared_ptr<const SourceFile> fromString(std::string text);
+
+    ~SourceFile();
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    std::string_view view() const { return { m_data, m_size }; }
+    const std::string& path() const { return m_path; }
+    // Whether the text is mapped from the file rather than copied.
+    bool isMapped() const { return m_mapped; }
+
+private:
+    SourceFile() = default;
+
+    std::string m_path;
+    std::string m_buffer; // Owns the text when it is not mapped
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+};
+
+} // namespace pep
@@ -15,68 +15,113 @@
  *******************************************************************************/
 #pragma once
 
+#include "../Interner.h"
 #include "Token.h"
+#include "pepino/types/types.h"
 
 #include <memory>
+#include <memory_resource>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 namespace pep
 {
-// Base class for all statements.
-class Statement
+// AST nodes are allocated from a per-feature memory resource, by default a
+// monotonic arena owned by the FeatureStatement, so building a feature costs a
+// handful of large allocations and freeing it releases them all at once. Every
+// container in a node allocates from the same resource as the node itself.
+using AstAllocator = std::pmr::polymorphic_allocator<>;
+
+// Returns a node to the resource it was allocated from.
+template <typename T> struct NodeDeleter
 {
-public:
-    virtual ~Statement() = default;
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    void operator()(T* node) const { AstAllocator(resource).delete_object(node); }
 };
 
-class StepStatement : public Statement
+template <typename T> using NodePtr = std::unique_ptr<T, NodeDeleter<T>>;
+
+class StepStatement
 {
 public:
-    std::string keyword;                                    // e.g., "Given", "When", "Then"
-    std::vector<Token> text;                                // The step text; may contain placeholders like "<var>"
-    std::unordered_map<std::string, std::string> variables; // Placeholder values
+    using allocator_type = AstAllocator;
+    explicit StepStatement(const allocator_type& alloc) : text(alloc) {}
+
+    types::StepType type = types::StepType::Given; // Keyword kind, independent of the dialect
+    Symbol keyword;                                // e.g., "Given", "When", "Then"
+    std::pmr::vector<Token> text; // The step text; placeholders like "<var>" are Placeholder tokens
 };
 
-class BackgroundStatement : public Statement
+class BackgroundStatement
 {
 public:
-    std::vector<std::unique_ptr<StepStatement>> steps;
+    using allocator_type = AstAllocator;
+    explicit BackgroundStatement(const allocator_type& alloc) : steps(alloc) {}
+
+    std::pmr::vector<NodePtr<StepStatement>> steps;
 };
 
-class ScenarioStatement : public Statement
+class ScenarioStatement
 {
 public:
-    std::vector<std::string> tags;
-    std::string name;
-    std::vector<std::unique_ptr<StepStatement>> steps;
+    using allocator_type = AstAllocator;
+    explicit ScenarioStatement(const allocator_type& alloc) : tags(alloc), name(alloc), steps(alloc) {}
+
+    std::pmr::vector<Symbol> tags;
+    std::pmr::string name;
+    std::pmr::vector<NodePtr<StepStatement>> steps;
 };
 
-class ExamplesStatement : public Statement
+class ExamplesStatement
 {
 public:
-    std::vector<std::string> headers;
-    std::vector<std::vector<std::string>> rows;
+    using allocator_type = AstAllocator;
+    explicit ExamplesStatement(const allocator_type& alloc) : headers(alloc), rows(alloc) {}
+
+    std::pmr::vector<std::string_view> headers;
+    std::pmr::vector<std::pmr::vector<std::string_view>> rows;
 };
 
-class ScenarioOutlineStatement : public Statement
+class ScenarioOutlineStatement
 {
 public:
-    std::vector<std::string> tags;
-    std::string name;
-    std::vector<std::unique_ptr<StepStatement>> steps;
-    std::unique_ptr<ExamplesStatement> examples;
+    using allocator_type = AstAllocator;
+    explicit ScenarioOutlineStatement(const allocator_type& alloc) : tags(alloc), name(alloc), steps(alloc) {}
+
+    std::pmr::vector<Symbol> tags;
+    std::pmr::string name;
+    std::pmr::vector<NodePtr<StepStatement>> steps;
+    NodePtr<ExamplesStatement> examples;
 };
 
-class FeatureStatement : public Statement
+class FeatureStatement
 {
 public:
-    std::vector<std::string> tags;
-    std::string name;
-    std::unique_ptr<BackgroundStatement> background;
-    std::vector<std::unique_ptr<ScenarioStatement>> scenarios;
-    std::vector<std::unique_ptr<ScenarioOutlineStatement>> scenarioOutlines;
+    // Allocates the tree from `resource`, or from an arena owned by this
+    // feature when `resource` is null.
+    explicit FeatureStatement(std::pmr::memory_resource* resource = nullptr)
+        : m_arena(resource ? nullptr : std::make_unique<std::pmr::monotonic_buffer_resource>()),
+          m_allocator(resource ? resource : m_arena.get()), tags(m_allocator), name(m_allocator),
+          scenarios(m_allocator), scenarioOutlines(m_allocator)
+    {
+    }
+    FeatureStatement(const FeatureStatement&) = delete;
+    FeatureStatement& operator=(const FeatureStatement&) = delete;
+
+    AstAllocator get_allocator() const { return m_allocator; }
+
+private:
+    // Declared first so the arena outlives every node allocated from it.
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> m_arena;
+    AstAllocator m_allocator;
+
+public:
+    std::pmr::vector<Symbol> tags;
+    std::pmr::string name;
+    NodePtr<BackgroundStatement> background;
+    std::pmr::vector<NodePtr<ScenarioStatement>> scenarios;
+    std::pmr::vector<NodePtr<ScenarioOutlineStatement>> scenarioOutlines;
 };
 
 } // namespace pep
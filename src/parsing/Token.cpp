@@ -27,6 +27,8 @@ std::string tokenAsString(const Token& token)
         return "Background";
     case TokenType::Feature:
         return "Feature";
+    case TokenType::Rule:
+        return "Rule";
     case TokenType::Scenario:
         return "Scenario";
     case TokenType::ScenarioOutline:
@@ -48,9 +50,9 @@ std::string tokenAsString(const Token& token)
     case TokenType::Pipe:
         return "|";
     case TokenType::Tag:
-        return "Tag->" + token.lexeme;
+        return "Tag->" + std::string(token.lexeme);
     case TokenType::StringLiteral:
-        return "Literal->" + token.lexeme;
+        return "Literal->" + std::string(token.lexeme);
     case TokenType::EOL:
         return "\\n";
     case TokenType::EndOfFile:
@@ -60,9 +62,9 @@ std::string tokenAsString(const Token& token)
     case TokenType::RightAngle:
         return ">";
     case TokenType::Identifier:
-        return "Identifier->" + token.lexeme;
+        return "Identifier->" + std::string(token.lexeme);
     case TokenType::Placeholder:
-        return "Placeholder->" + token.lexeme;
+        return "Placeholder->" + std::string(token.lexeme);
     default:
         return "Unknown";
     }
@@ -73,6 +75,7 @@ bool isKeyword(const TokenType& type)
     switch (type)
     {
     case TokenType::Feature:
+    case TokenType::Rule:
     case TokenType::Background:
     case TokenType::Scenario:
     case TokenType::ScenarioOutline:
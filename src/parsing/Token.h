@@ -16,6 +16,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 namespace pep
 {
@@ -24,6 +25,7 @@ enum class TokenType
 {
     // Structural keywords.
     Feature,
+    Rule,
     Background,
     Scenario,
     ScenarioOutline,
@@ -55,10 +57,13 @@ enum class TokenType
     Identifier
 };
 
+// A token does not own its text: `lexeme` views the source buffer the lexer
+// ran over (or a string literal for synthesized tokens), so that buffer must
+// outlive every token and AST node built from it.
 struct Token
 {
     TokenType type;
-    std::string lexeme;
+    std::string_view lexeme;
     int line;
 
     bool operator==(const Token& other) const = default;
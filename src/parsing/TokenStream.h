@@ -0,0 +1,55 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+#pragma once
+
+#include "Token.h"
+
+#include <vector>
+
+namespace pep
+{
+
+// TokenStream is a pull-based source of tokens for the Parser. Once the input
+// is exhausted, next() keeps returning an EndOfFile token.
+class TokenStream
+{
+public:
+    virtual ~TokenStream() = default;
+    virtual Token next() = 0;
+};
+
+// Replays an already tokenized vector (for tests and pre-built token lists).
+class TokenVectorStream : public TokenStream
+{
+public:
+    explicit TokenVectorStream(const std::vector<Token>& tokens)
+        : m_tokens(tokens)
+    {
+    }
+
+    Token next() override
+    {
+        if (m_current < m_tokens.size())
+            return m_tokens[m_current++];
+        return { TokenType::EndOfFile, "", m_tokens.empty() ? 1 : m_tokens.back().line };
+    }
+
+private:
+    const std::vector<Token>& m_tokens;
+    size_t m_current = 0;
+};
+
+} // namespace pep
@@ -16,21 +16,77 @@
 
 #include "pepino/pepino.h"
 #include "BasicTestRunner.h"
+#include "ParallelTestRunner.h"
+#include "ProcessPoolTestRunner.h"
 #include "TestController.h"
+#include "pepino/steps/StepRegistry.h"
 
 namespace pep
 {
 
+namespace
+{
+void applyOptions(const RunOptions& options)
+{
+    if (StepRegistry::getInstance().regexBackend() != options.regexBackend)
+    {
+        StepRegistry::getInstance().setRegexBackend(options.regexBackend);
+    }
+    if (StepRegistry::getInstance().matchStrategy() != options.matchStrategy)
+    {
+        StepRegistry::getInstance().setMatchStrategy(options.matchStrategy);
+    }
+    if (StepRegistry::getInstance().strictKeywords() != options.strictKeywords)
+    {
+        StepRegistry::getInstance().setStrictKeywords(options.strictKeywords);
+    }
+}
+
+std::unique_ptr<ITestRunner> makeRunner(const RunOptions& options)
+{
+    if (options.scenarioProcesses != 0)
+    {
+        return std::make_unique<ProcessPoolTestRunner>(options.scenarioProcesses,
+                                                       options.contextLifetime,
+                                                       WorkerLimits{ options.workerMemoryLimit, options.workerCpuSeconds });
+    }
+    if (options.scenarioThreads == 1)
+    {
+        return std::make_unique<BasicTestRunner>(options.contextLifetime);
+    }
+    return std::make_unique<ParallelTestRunner>(options.scenarioThreads, options.contextLifetime);
+}
+} // namespace
+
 int debug_runStep(const std::string& pattern)
 {
-    TestController interpreter(std::make_unique<BasicTestRunner>());
+    TestController interpreter(std::make_unique<BasicTestRunner>(types::ContextLifetime::Shared));
     return interpreter.executeTest(pattern);
 }
 
-int run(const std::string& filepath)
+// The defaults apply in full, also over the settings of an earlier run.
+int run(const std::string& path)
+{
+    return run(path, RunOptions{});
+}
+
+int run(const std::string& path, const RunOptions& options)
+{
+    applyOptions(options);
+    TestController interpreter(makeRunner(options), options);
+    return interpreter.executeTest(path);
+}
+
+int run(const std::vector<std::string>& paths)
+{
+    return run(paths, RunOptions{});
+}
+
+int run(const std::vector<std::string>& paths, const RunOptions& options)
 {
-    TestController interpreter(std::make_unique<BasicTestRunner>());
-    return interpreter.executeTest(filepath);
+    applyOptions(options);
+    TestController interpreter(makeRunner(options), options);
+    return interpreter.executeTests(paths);
 }
 
 } // namespace pep
@@ -0,0 +1,4 @@
+Feature Missing colon
+
+  Scenario: Never parsed
+    Given the user is on the login page
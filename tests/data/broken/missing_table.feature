@@ -0,0 +1,6 @@
+Feature: Missing examples table
+
+  Scenario Outline: Never parsed
+    When the user enters <username> and <password>
+
+    Examples:
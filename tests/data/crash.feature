@@ -0,0 +1,20 @@
+Feature: Crashing workers
+  A step that crashes takes down its worker, not the run.
+
+  Scenario: Before the crash
+    Given a counter starting at 1
+    When the counter is bumped after 1 ms
+    Then the counter shows 2
+
+  Scenario: The crash
+    Given a counter starting at 1
+    When the worker crashes
+
+  Scenario: After the crash
+    Given a counter starting at 4
+    When the counter is bumped after 1 ms
+    Then the counter shows 5
+
+  Scenario: Too much memory
+    Given a counter starting at 1
+    When the worker allocates 512 MB
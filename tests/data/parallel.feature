@@ -0,0 +1,24 @@
+Feature: Parallel scenarios
+  Each row counts in its own context, so the rows can run at once.
+
+  Scenario: A lone counter
+    Given a counter starting at 10
+    When the counter is bumped after 1 ms
+    Then the counter shows 11
+
+  Scenario Outline: Counting in isolation
+    Given a counter starting at <start>
+    When the counter is bumped after <delay> ms
+    And the counter is bumped after <delay> ms
+    Then the counter shows <end>
+
+    Examples:
+      | start | delay | end |
+      | 0     | 3     | 2   |
+      | 5     | 1     | 7   |
+      | 7     | 4     | 9   |
+      | 1     | 2     | 3   |
+      | 2     | 5     | 4   |
+      | 3     | 1     | 5   |
+      | 4     | 3     | 6   |
+      | 9     | 2     | 11  |
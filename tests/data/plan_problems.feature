@@ -0,0 +1,4 @@
+Feature: Plan problems
+  Scenario: Broken
+    Given a plan marker
+    And no step looks like this
@@ -0,0 +1,22 @@
+Feature: Shard problems
+  An undefined step only fails the shard that would run it.
+
+  Scenario: Broken
+    Given a counter starting at 1
+    When no step looks like this
+
+  Scenario: First
+    Given a counter starting at 1
+    Then the counter shows 1
+
+  Scenario: Second
+    Given a counter starting at 2
+    Then the counter shows 2
+
+  Scenario: Third
+    Given a counter starting at 3
+    Then the counter shows 3
+
+  Scenario: Fourth
+    Given a counter starting at 4
+    Then the counter shows 4
@@ -0,0 +1,10 @@
+Feature: Login errors
+
+  Scenario Outline: Unsuccessful login attempts
+    Given the user is on the login page
+    When the user enters <username> and <password>
+    Then they should see an error message
+
+    Examples:
+      | username | password  |
+      | user     | wrongpass |
@@ -14,10 +14,16 @@
  *
  *******************************************************************************/
 
+#include "../src/parsing/Keywords.h"
 #include "../src/parsing/Lexer.h"
+#include "../src/parsing/Scanner.h"
+#include "../src/parsing/SourceFile.h"
 
 #include <gtest/gtest.h>
+#include <cctype>
+#include <fstream>
 #include <iomanip>
+#include <random>
 
 using namespace pep;
 
@@ -176,3 +182,256 @@ TEST(LexerTest, ExamplesTable)
     EXPECT_TRUE(foundUsername);
     EXPECT_TRUE(foundPassword);
 }
+
+// Test 8: Tokens view the source buffer instead of copying it
+TEST(LexerTest, TokensViewSourceBuffer)
+{
+    std::string input = "@smoke\n"
+                        "Scenario Outline: login\n";
+    Lexer lexer(input);
+    auto tokens = lexer.tokenize();
+
+    ASSERT_GE(tokens.size(), 5);
+    EXPECT_EQ(tokens[0].lexeme.data(), input.data());
+    EXPECT_EQ(tokens[2].type, TokenType::ScenarioOutline);
+    EXPECT_EQ(tokens[2].lexeme, "Scenario Outline");
+    EXPECT_EQ(tokens[2].lexeme.data(), input.data() + 7);
+    EXPECT_EQ(tokens[4].lexeme, "login");
+    EXPECT_EQ(tokens[4].lexeme.data(), input.data() + 25);
+}
+
+// Tokenizes `input` with the given scanner instruction set, restoring the
+// previously active one afterwards.
+std::vector<Token> tokenizeWith(scan::Isa isa, const std::string& input)
+{
+    const auto previous = scan::activeIsa();
+    scan::setIsa(isa);
+    Lexer lexer(input);
+    auto tokens = lexer.tokenize();
+    scan::setIsa(previous);
+    return tokens;
+}
+
+bool isReferenceSpace(char c)
+{
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+// The reference the scanner kernels are held to: the original lexer's
+// char-by-char loop over std::isspace, with today's rules for comments and
+// keywords (English, only at the start of a line).
+std::vector<Token> referenceTokenize(const std::string& input)
+{
+    const std::string_view source = input;
+    std::vector<Token> tokens;
+    int line = 1;
+    bool atLineStart = true;
+    size_t current = 0;
+    while (current < source.size())
+    {
+        const size_t start = current;
+        const bool lineStart = atLineStart;
+        atLineStart = false;
+        const char c = source[current++];
+        if (c == '\n')
+        {
+            atLineStart = true;
+            tokens.push_back({ TokenType::EOL, "\\n", line++ });
+        }
+        else if (isReferenceSpace(c))
+        {
+            atLineStart = lineStart;
+        }
+        else if (c == '#' && lineStart)
+        {
+            while (current < source.size() && source[current] != '\n')
+                ++current;
+        }
+        else if (c == '@')
+        {
+            while (current < source.size() && !isReferenceSpace(source[current]))
+                ++current;
+            tokens.push_back({ TokenType::Tag, source.substr(start, current - start), line });
+        }
+        else if (c == ':' || c == '|' || c == '<' || c == '>')
+        {
+            const auto type = c == ':'   ? TokenType::Colon
+                              : c == '|' ? TokenType::Pipe
+                              : c == '<' ? TokenType::LeftAngle
+                                         : TokenType::RightAngle;
+            tokens.push_back({ type, source.substr(start, 1), line });
+        }
+        else
+        {
+            auto endsWord = [&source](size_t at)
+            {
+                return at >= source.size() || isReferenceSpace(source[at]) || source[at] == '<' ||
+                       source[at] == '>' || source[at] == ':';
+            };
+            while (!endsWord(current))
+                ++current;
+            auto type = TokenType::StringLiteral;
+            const auto word = source.substr(start, current - start);
+            for (const auto& phrase : lineStart ? Dialect::english().lookup(word) : std::span<const KeywordPhrase>{})
+            {
+                const auto rest = phrase.text.substr(word.size());
+                if (source.substr(current, rest.size()) == rest && endsWord(current + rest.size()))
+                {
+                    current += rest.size();
+                    type = phrase.type;
+                    break;
+                }
+            }
+            tokens.push_back({ type, source.substr(start, current - start), line });
+        }
+    }
+    tokens.push_back({ TokenType::EndOfFile, "", line });
+    return tokens;
+}
+
+// Expects both token streams to cover exactly the same bytes of `input`.
+void expectSameTokens(const std::string& input, const std::vector<Token>& expected, const std::vector<Token>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size()) << std::quoted(input);
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(expected[i], actual[i]) << "token " << i << " of " << std::quoted(input);
+        if (expected[i].type == TokenType::Tag || expected[i].type == TokenType::StringLiteral ||
+            isKeyword(expected[i].type))
+        {
+            EXPECT_EQ(expected[i].lexeme.data() - input.data(), actual[i].lexeme.data() - input.data());
+        }
+    }
+}
+
+// Test 9: Every scanner kernel emits the same tokens as the reference lexer
+TEST(LexerTest, ScanKernelsMatchReference)
+{
+    std::vector<std::string> inputs = {
+        "",
+        "@smoke @slow\nFeature: Login\n",
+        "Scenario Outline: many <placeholders> and words:with:colons\n",
+        "      | a_very_long_cell_value_that_spans_more_than_thirty_two_bytes | b |\r\n",
+        "\t\v\f  \n\n   Given a step with trailing blanks   \t ",
+        "\xc3\xa9t\xc3\xa9 \xff\x80 <ol\xc3\xa1> \x01\x7f",
+        "Feature:\tTabs\r\n\tScenario:\tCRLF\r\n\t\tGiven\ta\tstep\r\n",
+        "\xa0\x85\x1c\x1d\x1e\x1f \xa0\xc2\xa0word",
+        "# a comment with Given inside\n  # another\nThen done",
+    };
+
+    // Words, tags and blank runs ending just before, on and just after the
+    // 16- and 32-byte boundaries the vector kernels step by.
+    for (size_t length : { 15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65 })
+    {
+        inputs.push_back(std::string(length, 'x') + " tail");
+        inputs.push_back("@" + std::string(length - 1, 't') + "\tnext");
+        inputs.push_back(std::string(length, '\x80') + ":\xff");
+        inputs.push_back(std::string(length, ' ') + "word");
+        inputs.push_back(std::string(length, '\t') + "\r\n" + std::string(length, '\v') + "<x>");
+        inputs.push_back("Given " + std::string(length, 'w') + "\r\n");
+    }
+
+    // Random mixes of words, delimiters and whitespace at every alignment and
+    // across 16/32-byte boundaries.
+    const std::string alphabet = "ab@|<>: \t\n\r\v\fxyzScenario0123\x80\xff\xa0\x1c";
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 500; ++i)
+    {
+        std::string input(rng() % 200, ' ');
+        for (auto& c : input)
+        {
+            c = alphabet[rng() % alphabet.size()];
+        }
+        inputs.push_back(std::move(input));
+    }
+
+    for (const auto& input : inputs)
+    {
+        const auto expected = referenceTokenize(input);
+        for (auto isa : { scan::Isa::Scalar, scan::Isa::Sse2, scan::Isa::Avx2 })
+        {
+            if (!scan::isSupported(isa))
+            {
+                continue;
+            }
+            SCOPED_TRACE(scan::isaName(isa));
+            expectSameTokens(input, expected, tokenizeWith(isa, input));
+        }
+    }
+}
+
+// Test 10: Multi-word keywords and keywords only at the start of a line
+TEST(LexerTest, KeywordsOnlyOpenLines)
+{
+    std::string input = "Scenario Template: a Scenario with Examples\n"
+                        "  * the user And the admin\n";
+    Lexer lexer(input);
+    auto tokens = lexer.tokenize();
+
+    ASSERT_GE(tokens.size(), 13);
+    EXPECT_EQ(tokens[0].type, TokenType::ScenarioOutline);
+    EXPECT_EQ(tokens[0].lexeme, "Scenario Template");
+    EXPECT_EQ(tokens[1].type, TokenType::Colon);
+    EXPECT_EQ(tokens[3].type, TokenType::StringLiteral);  // "Scenario"
+    EXPECT_EQ(tokens[5].type, TokenType::StringLiteral);  // "Examples"
+    EXPECT_EQ(tokens[7].type, TokenType::And);            // "*"
+    EXPECT_EQ(tokens[10].type, TokenType::StringLiteral); // "And"
+}
+
+// Test 11: Comments are skipped and "# language:" selects the dialect
+TEST(LexerTest, LanguageHeaderSelectsDialect)
+{
+    std::string input = "# language: fr\n"
+                        "# un commentaire\n"
+                        "Fonctionnalité: Connexion\n"
+                        "  Plan du scénario: essai\n"
+                        "    Étant donné que l'utilisateur existe\n"
+                        "    Et un autre\n";
+    Lexer lexer(input);
+    auto tokens = lexer.tokenize();
+
+    std::vector<Token> keywords;
+    for (const auto& token : tokens)
+    {
+        if (isKeyword(token.type))
+        {
+            keywords.push_back(token);
+        }
+    }
+    ASSERT_EQ(keywords.size(), 4);
+    EXPECT_EQ(keywords[0].type, TokenType::Feature);
+    EXPECT_EQ(keywords[1].type, TokenType::ScenarioOutline);
+    EXPECT_EQ(keywords[1].lexeme, "Plan du scénario");
+    EXPECT_EQ(keywords[2].type, TokenType::Given);
+    EXPECT_EQ(keywords[2].lexeme, "Étant donné que");
+    EXPECT_EQ(keywords[3].type, TokenType::And);
+    // The two comment lines leave only their newlines behind.
+    EXPECT_EQ(tokens[0].type, TokenType::EOL);
+    EXPECT_EQ(tokens[1].type, TokenType::EOL);
+}
+
+// Test 12: Unknown languages are rejected
+TEST(LexerTest, UnsupportedLanguageThrows)
+{
+    std::string input = "#language:xx\nFeature: x\n";
+    EXPECT_THROW(Lexer{ input }, std::runtime_error);
+}
+
+// Test 13: Feature files are mapped, everything else is read into a buffer
+TEST(LexerTest, SourceFileMapsRegularFiles)
+{
+    auto source = SourceFile::open("tests/data/one_step.feature");
+    EXPECT_TRUE(source->isMapped());
+    std::ifstream file("tests/data/one_step.feature");
+    const std::string expected((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(source->view(), expected);
+
+    auto tokens = Lexer(source->view()).tokenize();
+    EXPECT_EQ(tokens.front().lexeme.data(), source->view().data() + source->view().find("Feature"));
+
+    auto devNull = SourceFile::open("/dev/null");
+    EXPECT_FALSE(devNull->isMapped());
+    EXPECT_TRUE(devNull->view().empty());
+
+    EXPECT_THROW(SourceFile::open("tests/data/does_not_exist.feature"), std::runtime_error);
+}
@@ -15,10 +15,19 @@
  *
  *******************************************************************************/
 
+#include "../src/parsing/FeatureCache.h"
+#include "../src/parsing/FlatFeature.h"
+#include "../src/parsing/Lexer.h"
 #include "../src/parsing/Parser.h"
 
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <memory_resource>
+#include <thread>
 #include <vector>
 
 using namespace pep;
@@ -77,7 +86,7 @@ TEST(ParserTest, ParseFeatureWithBackground)
     EXPECT_EQ(feature->background->steps.size(), 1);
     auto& step = feature->background->steps[0];
     EXPECT_EQ(step->keyword, "Given");
-    std::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "a user exists", 2 } };
+    std::pmr::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "a user exists", 2 } };
     EXPECT_EQ(step->text, expectedText);
 }
 
@@ -128,7 +137,7 @@ TEST(ParserTest, ParseFeatureWithScenario)
     ASSERT_EQ(scenario->steps.size(), 1);
     auto& step = scenario->steps[0];
     EXPECT_EQ(step->keyword, "Given");
-    std::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "user is logged in", 3 } };
+    std::pmr::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "user is logged in", 3 } };
     EXPECT_EQ(step->text, expectedText);
 }
 
@@ -193,7 +202,7 @@ TEST(ParserTest, ParseFeatureWithScenarioOutline)
     auto& step = outline->steps[0];
     EXPECT_EQ(step->keyword, "Given");
 
-    std::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "user ", 3 },
+    std::pmr::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "user ", 3 },
                                         Token{ TokenType::Placeholder, "username", 3 },
                                         Token{ TokenType::StringLiteral, " attempts login", 3 } };
 
@@ -248,7 +257,7 @@ TEST(ParserTest, ParseFeatureWithDescription)
     ASSERT_EQ(scenario->steps.size(), 1);
     auto& step = scenario->steps[0];
     EXPECT_EQ(step->keyword, "Given");
-    std::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "a step in the scenario", 5 } };
+    std::pmr::vector<Token> expectedText = { Token{ TokenType::StringLiteral, "a step in the scenario", 5 } };
     EXPECT_EQ(step->text, expectedText);
 }
 
@@ -280,4 +289,294 @@ TEST(ParserTest, InvalidKeywordThrows)
 
     Parser parser(tokens);
     EXPECT_THROW({ auto feature = parser.parseFeature(); }, std::runtime_error);
-}
\ No newline at end of file
+}
+// ----------------------------------------------------
+// Dialect keywords, "*" steps and Rules end to end
+// ----------------------------------------------------
+TEST(ParserTest, ParseDialectFeatureWithRule)
+{
+    std::string source = "# language: de\n"
+                         "Funktionalität: Anmeldung\n"
+                         "  Regel: Nur bekannte Benutzer\n"
+                         "    Szenario: Gültige Anmeldung\n"
+                         "      Angenommen ein Benutzer\n"
+                         "      * meldet sich an\n"
+                         "      Dann klappt es\n";
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens);
+    std::unique_ptr<FeatureStatement> feature = parser.parseFeature();
+    ASSERT_NE(feature, nullptr);
+    EXPECT_EQ(feature->name, "Anmeldung");
+    ASSERT_EQ(feature->scenarios.size(), 1);
+    const auto& steps = feature->scenarios[0]->steps;
+    ASSERT_EQ(steps.size(), 3);
+    EXPECT_EQ(steps[0]->type, types::StepType::Given);
+    EXPECT_EQ(steps[0]->keyword, "Angenommen");
+    EXPECT_EQ(steps[1]->type, types::StepType::And);
+    EXPECT_EQ(steps[1]->keyword, "*");
+    EXPECT_EQ(steps[2]->type, types::StepType::Then);
+}
+
+TEST(ParserTest, BackgroundInsideRuleThrows)
+{
+    // Rules are not kept in the AST, so a Rule's Background would also run
+    // before the scenarios outside the Rule and replace the Feature's own.
+    std::string source = "Feature: Login\n"
+                         "  Background:\n"
+                         "    Given a feature background\n"
+                         "  Scenario: Before the rule\n"
+                         "    Given a step\n"
+                         "  Rule: Known users\n"
+                         "    Background:\n"
+                         "      Given a rule background\n"
+                         "    Scenario: In the rule\n"
+                         "      Given a step\n";
+    Lexer lexer(source);
+    Parser parser(lexer);
+    try
+    {
+        parser.parseFeature();
+        FAIL() << "Expected the Rule's Background to be rejected";
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_NE(std::string(e.what()).find("Background inside a Rule"), std::string::npos) << e.what();
+    }
+
+    std::string twice = "Feature: Login\n"
+                        "  Background:\n"
+                        "    Given one\n"
+                        "  Background:\n"
+                        "    Given another\n";
+    Lexer twiceLexer(twice);
+    Parser twiceParser(twiceLexer);
+    EXPECT_THROW(twiceParser.parseFeature(), std::runtime_error);
+
+    // The Feature's Background with scenarios inside a Rule is fine.
+    std::string ruled = "Feature: Login\n"
+                        "  Background:\n"
+                        "    Given a feature background\n"
+                        "  Rule: Known users\n"
+                        "    Scenario: In the rule\n"
+                        "      Given a step\n";
+    Lexer ruledLexer(ruled);
+    Parser ruledParser(ruledLexer);
+    auto feature = ruledParser.parseFeature();
+    ASSERT_NE(feature, nullptr);
+    ASSERT_NE(feature->background, nullptr);
+    EXPECT_EQ(feature->background->steps.size(), 1u);
+    EXPECT_EQ(feature->scenarios.size(), 1u);
+}
+
+// ----------------------------------------------------
+// Streaming: the parser pulls tokens from the lexer on demand
+// ----------------------------------------------------
+TEST(ParserTest, ParseStreamsFromLexer)
+{
+    // Counts how many tokens the parser has pulled so far.
+    class CountingStream : public TokenStream
+    {
+    public:
+        explicit CountingStream(TokenStream& inner) : m_inner(inner) {}
+        Token next() override
+        {
+            ++pulled;
+            return m_inner.next();
+        }
+        size_t pulled = 0;
+
+    private:
+        TokenStream& m_inner;
+    };
+
+    std::string source = "Feature: Streaming\n"
+                         "  Scenario: One\n"
+                         "    Given a step\n"
+                         "    Then another step\n";
+    Lexer lexer(source);
+    CountingStream stream(lexer);
+    Parser parser(stream);
+    // Only the first token is read before parsing starts.
+    EXPECT_EQ(stream.pulled, 1);
+
+    std::unique_ptr<FeatureStatement> feature = parser.parseFeature();
+    ASSERT_NE(feature, nullptr);
+    EXPECT_EQ(feature->name, "Streaming");
+    ASSERT_EQ(feature->scenarios.size(), 1);
+    ASSERT_EQ(feature->scenarios[0]->steps.size(), 2);
+    EXPECT_EQ(feature->scenarios[0]->steps[1]->keyword, "Then");
+
+    Lexer reference(source);
+    EXPECT_EQ(stream.pulled, reference.tokenize().size());
+}
+
+// ----------------------------------------------------
+// The whole tree is allocated from the given resource
+// ----------------------------------------------------
+TEST(ParserTest, ParseAllocatesFromResource)
+{
+    std::string source = "@tagged\n"
+                         "Feature: Arena\n"
+                         "  Scenario Outline: Outline\n"
+                         "    Given a <thing>\n"
+                         "    Examples:\n"
+                         "      | thing |\n"
+                         "      | one   |\n"
+                         "      | two   |\n";
+    // A fixed buffer with no upstream: any allocation outside it throws.
+    std::array<std::byte, 16 * 1024> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+    Lexer lexer(source);
+    Parser parser(lexer, &arena);
+    std::unique_ptr<FeatureStatement> feature = parser.parseFeature();
+    ASSERT_NE(feature, nullptr);
+    EXPECT_EQ(feature->get_allocator().resource(), &arena);
+    ASSERT_EQ(feature->scenarioOutlines.size(), 1);
+    const auto& outline = *feature->scenarioOutlines[0];
+    EXPECT_EQ(outline.steps[0]->text.get_allocator().resource(), &arena);
+    ASSERT_NE(outline.examples, nullptr);
+    EXPECT_EQ(outline.examples->rows.size(), 2);
+}
+
+// ----------------------------------------------------
+// Flattening keeps the tree's structure and text
+// ----------------------------------------------------
+TEST(ParserTest, FlattenFeature)
+{
+    std::string source = "@feature\n"
+                         "Feature: Flat\n"
+                         "  Background:\n"
+                         "    Given a   clean slate\n"
+                         "  @outline\n"
+                         "  Scenario Outline: Outline\n"
+                         "    When I add <a> and <b>\n"
+                         "    Examples:\n"
+                         "      | a | b |\n"
+                         "      | 1 | 2 |\n"
+                         "      | 3 | 4 |\n"
+                         "  Scenario: Plain\n"
+                         "    Then it works\n";
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto flat = FlatFeature::flatten(*parser.parseFeature());
+
+    EXPECT_EQ(flat.name.view(), "Flat");
+    ASSERT_EQ(flat.tags.count, 1);
+    EXPECT_EQ(flat.tagText[flat.tags.first].view(), "@feature");
+    ASSERT_TRUE(flat.hasBackground);
+    ASSERT_EQ(flat.background.count, 1);
+    EXPECT_EQ(flat.stepText[flat.background.first].view(), "a clean slate");
+
+    // Plain scenarios come first, then outlines.
+    ASSERT_EQ(flat.scenarioCount(), 2);
+    EXPECT_EQ(flat.scenarioName[0].view(), "Plain");
+    EXPECT_EQ(flat.scenarioOutline[0], 0);
+    EXPECT_EQ(flat.scenarioExamples[0], FlatFeature::None);
+    EXPECT_EQ(flat.scenarioName[1].view(), "Outline");
+    EXPECT_EQ(flat.scenarioOutline[1], 1);
+    ASSERT_EQ(flat.scenarioTags[1].count, 1);
+    EXPECT_EQ(flat.tagText[flat.scenarioTags[1].first].view(), "@outline");
+
+    // The outline step keeps its placeholders and has no precomputed text.
+    const auto step = flat.scenarioSteps[1].first;
+    EXPECT_EQ(flat.stepType[step], types::StepType::When);
+    EXPECT_TRUE(flat.stepText[step].empty());
+    const auto tokens = flat.stepTokens[step];
+    ASSERT_EQ(tokens.count, 5);
+    EXPECT_EQ(flat.tokenType[tokens.first + 2], TokenType::Placeholder);
+    EXPECT_EQ(flat.tokenText[tokens.first + 2].view(), "a");
+
+    const auto examples = flat.scenarioExamples[1];
+    ASSERT_NE(examples, FlatFeature::None);
+    EXPECT_EQ(flat.examplesHeaders[examples].count, 2);
+    const auto rows = flat.examplesRows[examples];
+    ASSERT_EQ(rows.count, 2);
+    const auto secondRow = flat.rowCells[rows.first + 1];
+    EXPECT_EQ(flat.cellText[secondRow.first].view(), "3");
+    EXPECT_EQ(flat.cellText[secondRow.first + 1].view(), "4");
+}
+
+// ----------------------------------------------------
+// Cached features round-trip and go stale on any change
+// ----------------------------------------------------
+TEST(ParserTest, FeatureCacheRoundTrip)
+{
+    const auto directory = std::filesystem::temp_directory_path() /
+                           ("pepino_cache_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()));
+    std::filesystem::remove_all(directory);
+    FeatureCache cache(directory);
+
+    std::string source = "Feature: Cached\n"
+                         "  Scenario Outline: Outline\n"
+                         "    Given a <thing>\n"
+                         "    Examples:\n"
+                         "      | thing |\n"
+                         "      | one   |\n";
+    EXPECT_FALSE(cache.load(source).has_value());
+
+    Lexer lexer(source);
+    Parser parser(lexer);
+    const auto flat = FlatFeature::flatten(*parser.parseFeature());
+    cache.store(source, flat);
+
+    auto loaded = cache.load(source);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->name, "Cached");
+    EXPECT_EQ(loaded->scenarioName, flat.scenarioName);
+    EXPECT_EQ(loaded->stepTokens, flat.stepTokens);
+    EXPECT_EQ(loaded->cellText, flat.cellText);
+    EXPECT_EQ(loaded->scenarioExamples, flat.scenarioExamples);
+
+    // Different content never hits the entry.
+    EXPECT_FALSE(cache.load(source + "\n").has_value());
+
+    // A damaged entry is ignored rather than trusted.
+    {
+        std::fstream entry(cache.entryPath(source), std::ios::in | std::ios::out | std::ios::binary);
+        entry.seekp(-1, std::ios::end);
+        entry.put('\x7f');
+    }
+    EXPECT_FALSE(cache.load(source).has_value());
+
+    std::filesystem::remove_all(directory);
+}
+
+// ----------------------------------------------------
+// Repeated text is interned once across features and threads
+// ----------------------------------------------------
+TEST(ParserTest, InternedTextIsShared)
+{
+    auto flattenSource = [](const std::string& source)
+    {
+        Lexer lexer(source);
+        Parser parser(lexer);
+        return FlatFeature::flatten(*parser.parseFeature());
+    };
+    const auto first = flattenSource("@login\nFeature: One\n  Scenario: A\n    Given the user is on the login page\n");
+    const auto second = flattenSource("@login\nFeature: Two\n  Scenario: B\n    Given the user is on the login page\n");
+
+    EXPECT_EQ(first.stepText[0], second.stepText[0]);
+    EXPECT_EQ(first.stepText[0].view().data(), second.stepText[0].view().data());
+    EXPECT_EQ(first.tagText[0], second.tagText[0]);
+    EXPECT_NE(first.name, second.name);
+
+    // Concurrent interning of the same strings agrees on every symbol.
+    std::vector<std::vector<Symbol>> results(4);
+    std::vector<std::thread> threads;
+    for (auto& result : results)
+    {
+        threads.emplace_back(
+            [&result]
+            {
+                for (int i = 0; i < 2000; ++i)
+                    result.push_back(intern("concurrent step " + std::to_string(i)));
+            });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (const auto& result : results)
+        EXPECT_EQ(result, results[0]);
+    EXPECT_EQ(results[0][42], "concurrent step 42");
+}
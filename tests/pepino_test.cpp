@@ -14,11 +14,28 @@
  *
  *******************************************************************************/
 
+#include "../src/BasicTestRunner.h"
+#include "../src/ExecutionPlan.h"
+#include "../src/ParallelTestRunner.h"
+#include "../src/ProcessPoolTestRunner.h"
+#include "../src/ResultFile.h"
+#include "../src/Sharding.h"
+#include "../src/WorkStealingScheduler.h"
+#include "../src/parsing/Lexer.h"
+#include "../src/parsing/Parser.h"
 #include "pepino/hooks/hooks.h"
 #include "pepino/pepino.h"
 #include "pepino/steps/steps.h"
 
+#include <atomic>
+#include <csignal>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <set>
+#include <string_view>
+#include <thread>
 
 class PepinoTest : public testing::Test
 {
@@ -77,3 +94,573 @@ TEST_F(PepinoTest, pepinoRuns)
     auto ret = pep::run("tests/data/normal_pepino.feature");
     EXPECT_EQ(ret, 0);
 }
+
+TEST_F(PepinoTest, pepinoRunsFromCache)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "pepino_run_cache_test";
+    std::filesystem::remove_all(directory);
+    pep::RunOptions options{ .cacheDirectory = directory.string() };
+
+    // The first run parses and fills the cache, the second one runs from it.
+    EXPECT_EQ(pep::run("tests/data/normal_pepino.feature", options), 0);
+    EXPECT_FALSE(std::filesystem::is_empty(directory));
+    EXPECT_EQ(pep::run("tests/data/normal_pepino.feature", options), 0);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(PepinoTest, pepinoRunsDirectoryGlobAndList)
+{
+    EXPECT_EQ(pep::run("tests/data/suite"), 0);
+    EXPECT_EQ(pep::run("tests/data/suite/*.feature"), 0);
+    EXPECT_EQ(pep::run(std::vector<std::string>{ "tests/data/suite/login_errors.feature",
+                                                 "tests/data/normal_pepino.feature" }),
+              0);
+    EXPECT_THROW(pep::run("tests/data/suite/*.missing"), std::runtime_error);
+}
+
+TEST_F(PepinoTest, runWithoutOptionsRestoresTheDefaults)
+{
+    pep::RunOptions options;
+    options.matchStrategy = pep::types::MatchStrategy::Linear;
+    options.strictKeywords = true;
+    EXPECT_EQ(pep::run("tests/data/normal_pepino.feature", options), 0);
+    EXPECT_TRUE(pep::StepRegistry::getInstance().strictKeywords());
+
+    EXPECT_EQ(pep::run("tests/data/normal_pepino.feature"), 0);
+    EXPECT_EQ(pep::StepRegistry::getInstance().matchStrategy(), pep::types::MatchStrategy::Tiered);
+    EXPECT_FALSE(pep::StepRegistry::getInstance().strictKeywords());
+}
+
+TEST_F(PepinoTest, pepinoReportsEveryParseError)
+{
+    try
+    {
+        pep::run("tests/data/broken");
+        FAIL() << "Expected the broken features to be reported";
+    }
+    catch (const std::runtime_error& e)
+    {
+        const std::string message = e.what();
+        EXPECT_NE(message.find("Failed to load 2 of 3 feature files"), std::string::npos) << message;
+        EXPECT_NE(message.find("missing_colon.feature"), std::string::npos) << message;
+        EXPECT_NE(message.find("missing_table.feature"), std::string::npos) << message;
+        EXPECT_EQ(message.find("good.feature"), std::string::npos) << message;
+    }
+}
+
+namespace
+{
+bool planMarkerRan = false;
+
+pep::FlatFeature flatFor(std::string_view source)
+{
+    pep::Lexer lexer(source);
+    pep::Parser parser(lexer);
+    return pep::FlatFeature::flatten(*parser.parseFeature());
+}
+
+pep::ExecutionPlan planFor(std::string_view source)
+{
+    return pep::ExecutionPlan::compile(flatFor(source));
+}
+} // namespace
+
+GIVEN("^a plan marker$", [](pep::DefaultContext&) { planMarkerRan = true; });
+GIVEN("^a plan step (a|b)$", [](pep::DefaultContext&, std::string) {});
+GIVEN("^a plan step (b|c)$", [](pep::DefaultContext&, std::string) {});
+GIVEN("^a plan count of (\\w+)$", [](pep::DefaultContext&, int) {});
+
+TEST_F(PepinoTest, planExpandsOutlinesAndInlinesTheBackground)
+{
+    std::ifstream file("tests/data/normal_pepino.feature");
+    const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const auto plan = planFor(source);
+
+    EXPECT_TRUE(plan.problems().empty());
+    ASSERT_EQ(plan.scenarios().size(), 3u); // The scenario, then one per example row
+    for (const auto& scenario : plan.scenarios())
+    {
+        ASSERT_EQ(scenario.stepCount, 4u);
+        EXPECT_EQ(plan.steps(scenario)[0].text, "a user exists with username \"user\" and password \"pass\"");
+    }
+    EXPECT_EQ(plan.scenarios()[2].info.name, "Unsuccessful login attempts");
+    EXPECT_EQ(plan.steps(plan.scenarios()[2])[2].text, "the user enters unknown and pass");
+    EXPECT_EQ(plan.steps(plan.scenarios()[2])[2].type, pep::types::StepType::When);
+
+    // Substituted texts belong to the plan and survive it being moved around.
+    std::vector<pep::ExecutionPlan> plans;
+    for (int i = 0; i < 9; ++i)
+    {
+        plans.push_back(planFor(source));
+    }
+    EXPECT_EQ(plans.front().steps(plans.front().scenarios()[2])[2].text, "the user enters unknown and pass");
+}
+
+TEST_F(PepinoTest, planReportsEveryUnrunnableStepBeforeRunning)
+{
+    const auto plan = planFor("Feature: Plan problems\n"
+                              "  Scenario: Broken\n"
+                              "    Given a plan marker\n"
+                              "    And no step looks like this\n"
+                              "    And a plan step b\n"
+                              "    And a plan count of many\n"
+                              "    And no step looks like this\n");
+    ASSERT_EQ(plan.problems().size(), 3u); // The undefined step is reported once
+    EXPECT_EQ(plan.problems()[0].step, "no step looks like this");
+    EXPECT_EQ(plan.problems()[0].message, "Undefined step");
+    EXPECT_NE(plan.problems()[1].message.find("Ambiguous"), std::string::npos);
+    EXPECT_NE(plan.problems()[2].message.find("Cannot convert 'many' to integer"), std::string::npos);
+
+    // Nothing runs, not even the steps before the undefined one.
+    planMarkerRan = false;
+    EXPECT_EQ(pep::run("tests/data/plan_problems.feature"), 42);
+    EXPECT_FALSE(planMarkerRan);
+}
+
+TEST_F(PepinoTest, planGivesAndAndButTheKeywordBeforeThem)
+{
+    using pep::types::StepType;
+    const auto plan = planFor("Feature: Keywords\n"
+                              "  Background:\n"
+                              "    And a plan marker\n"
+                              "  Scenario: Inherited\n"
+                              "    And a plan marker\n"
+                              "    When a plan marker\n"
+                              "    But a plan marker\n"
+                              "    Then a plan marker\n"
+                              "    And a plan marker\n");
+    ASSERT_EQ(plan.scenarios().size(), 1u);
+    const auto steps = plan.steps(plan.scenarios()[0]);
+    const std::vector<StepType> keywords{ StepType::Given, StepType::Given, StepType::When,
+                                          StepType::When,  StepType::Then,  StepType::Then };
+    ASSERT_EQ(steps.size(), keywords.size());
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        EXPECT_EQ(steps[i].keyword, keywords[i]) << "step " << i;
+    }
+    EXPECT_EQ(steps[3].type, StepType::But);
+}
+
+class CounterContext : public pep::Context<CounterContext>
+{
+public:
+    int value = 0;
+};
+
+GIVEN_CTX(CounterContext, "^a counter starting at (\\d+)$", [](CounterContext& ctx, int start) { ctx.value = start; });
+WHEN_CTX(CounterContext,
+         "^the counter is bumped after (\\d+) ms$",
+         [](CounterContext& ctx, std::chrono::milliseconds delay)
+         {
+             const int seen = ctx.value;
+             std::this_thread::sleep_for(delay); // Lets other scenarios interleave
+             ctx.value = seen + 1;
+         });
+THEN_CTX(CounterContext,
+         "^the counter shows (\\d+)$",
+         [](CounterContext& ctx, int expected)
+         {
+             if (ctx.value != expected)
+                 throw std::runtime_error("counter is " + std::to_string(ctx.value));
+         });
+
+TEST_F(PepinoTest, parallelRunnerGivesEachScenarioItsOwnContext)
+{
+    pep::RunOptions options;
+    options.scenarioThreads = 4;
+    EXPECT_EQ(pep::run("tests/data/parallel.feature", options), 0);
+    EXPECT_EQ(CounterContext::getInstance().value, 0); // The process-wide context was never used
+}
+
+TEST_F(PepinoTest, parallelResultsFollowThePlanOrder)
+{
+    const auto plan = planFor("Feature: Parallel results\n"
+                              "  Scenario Outline: Rows\n"
+                              "    Given a counter starting at <start>\n"
+                              "    When the counter is bumped after 2 ms\n"
+                              "    Then the counter shows <end>\n"
+                              "    Examples:\n"
+                              "      | start | end |\n"
+                              "      | 1     | 2   |\n"
+                              "      | 2     | 4   |\n"
+                              "      | 3     | 4   |\n"
+                              "      | 4     | 9   |\n");
+    ASSERT_TRUE(plan.problems().empty());
+    const auto results = pep::ParallelTestRunner(3).runPlan(plan);
+    ASSERT_EQ(results.size(), 4u);
+    using Status = pep::ScenarioResult::Status;
+    EXPECT_EQ(results[0].status, Status::Passed);
+    EXPECT_EQ(results[1].status, Status::Error);
+    EXPECT_EQ(results[1].message, "Rows: counter is 3");
+    EXPECT_EQ(results[2].status, Status::Passed);
+    EXPECT_EQ(results[3].message, "Rows: counter is 5");
+    for (const auto& result : results)
+    {
+        EXPECT_GE(result.duration, std::chrono::milliseconds(2));
+    }
+}
+
+TEST_F(PepinoTest, eachScenarioStartsWithAFreshContext)
+{
+    const auto feature = flatFor("Feature: Context lifetime\n"
+                                 "  Scenario: Leaves state behind\n"
+                                 "    Given a counter starting at 5\n"
+                                 "  Scenario: Expects none\n"
+                                 "    When the counter is bumped after 0 ms\n"
+                                 "    Then the counter shows 1\n");
+    EXPECT_EQ(pep::BasicTestRunner(pep::types::ContextLifetime::Scenario).runTests(feature), 0);
+    EXPECT_EQ(pep::ParallelTestRunner(2, pep::types::ContextLifetime::Scenario).runTests(feature), 0);
+
+    // Shared contexts keep the counter from the first scenario.
+    EXPECT_NE(pep::BasicTestRunner(pep::types::ContextLifetime::Shared).runTests(feature), 0);
+    CounterContext::getInstance().value = 0;
+}
+
+class PooledContext : public pep::Context<PooledContext>
+{
+public:
+    PooledContext() { ++constructed; }
+    void reset()
+    {
+        ++resets;
+        words.clear(); // Keeps the capacity
+    }
+
+    std::vector<std::string> words;
+    static inline int constructed = 0;
+    static inline int resets = 0;
+};
+
+GIVEN_CTX(PooledContext,
+          "^the pooled words are empty$",
+          [](PooledContext& ctx)
+          {
+              if (!ctx.words.empty())
+                  throw std::runtime_error("state leaked");
+          });
+WHEN_CTX(PooledContext,
+         "^a pooled word (\\w+) is added$",
+         [](PooledContext& ctx, std::string word) { ctx.words.push_back(std::move(word)); });
+
+TEST_F(PepinoTest, pooledContextsAreResetAndReused)
+{
+    const auto feature = flatFor("Feature: Pooled contexts\n"
+                                 "  Scenario Outline: Rows\n"
+                                 "    Given the pooled words are empty\n"
+                                 "    When a pooled word <word> is added\n"
+                                 "    Examples:\n"
+                                 "      | word |\n"
+                                 "      | one  |\n"
+                                 "      | two  |\n"
+                                 "      | six  |\n");
+    EXPECT_EQ(pep::BasicTestRunner(pep::types::ContextLifetime::Pooled).runTests(feature), 0);
+    EXPECT_EQ(PooledContext::constructed, 1);
+    EXPECT_EQ(PooledContext::resets, 3);
+    EXPECT_EQ(pep::ContextPool<PooledContext>::size(), 1u);
+
+    // Per-scenario contexts without pooling are rebuilt every time.
+    EXPECT_EQ(pep::BasicTestRunner(pep::types::ContextLifetime::Scenario).runTests(feature), 0);
+    EXPECT_EQ(PooledContext::constructed, 4);
+    EXPECT_EQ(PooledContext::resets, 3);
+}
+
+TEST_F(PepinoTest, idleWorkersStealLongTasks)
+{
+    // The first block of tasks is much slower than the rest; without stealing
+    // one worker would run all four long ones back to back.
+    constexpr size_t Tasks = 16;
+    std::vector<std::atomic<int>> runs(Tasks);
+    const auto task = [&](size_t i)
+    {
+        ++runs[i];
+        std::this_thread::sleep_for(std::chrono::milliseconds(i < 4 ? 30 : 1));
+    };
+    const auto stats = pep::WorkStealingScheduler(4).run(Tasks, task);
+    for (const auto& count : runs)
+    {
+        EXPECT_EQ(count, 1);
+    }
+    EXPECT_EQ(stats.tasks, Tasks);
+    EXPECT_EQ(stats.busy.size(), 4u);
+    EXPECT_GT(stats.steals, 0u);
+    EXPECT_LE(stats.idle(), stats.wall * 4);
+    EXPECT_NE(stats.summary().find("16 scenarios on 4 workers"), std::string::npos);
+}
+
+TEST_F(PepinoTest, parallelRunsScheduleSeveralFeaturesTogether)
+{
+    pep::RunOptions options;
+    options.scenarioThreads = 3;
+    EXPECT_EQ(pep::run(std::vector<std::string>{ "tests/data/parallel.feature", "tests/data/normal_pepino.feature" },
+                       options),
+              0);
+}
+
+TEST_F(PepinoTest, shardsSplitTheScenariosAndMergeBack)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "pepino_shard_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const std::vector<std::string> features{ "tests/data/parallel.feature", "tests/data/normal_pepino.feature" };
+
+    pep::RunOptions whole;
+    whole.scenarioThreads = 2;
+    whole.resultFile = (directory / "whole").string();
+    ASSERT_EQ(pep::run(features, whole), 0);
+    std::set<std::string> all;
+    for (const auto& result : pep::ResultFile::read(whole.resultFile).results)
+    {
+        all.insert(result.id);
+    }
+    EXPECT_EQ(all.size(), 12u);
+
+    std::vector<pep::ResultFile> shards;
+    for (unsigned index : { 2u, 0u, 1u })
+    {
+        pep::RunOptions options = whole;
+        options.shardIndex = index;
+        options.shardCount = 3;
+        options.resultFile = (directory / std::to_string(index)).string();
+        ASSERT_EQ(pep::run(features, options), 0);
+        shards.push_back(pep::ResultFile::read(options.resultFile));
+        EXPECT_EQ(shards.back().shardIndex, index);
+        EXPECT_EQ(shards.back().shardCount, 3u);
+
+        // The same shard gets the same scenarios every time.
+        ASSERT_EQ(pep::run(features, options), 0);
+        const auto again = pep::ResultFile::read(options.resultFile);
+        ASSERT_EQ(again.results.size(), shards.back().results.size());
+        for (size_t i = 0; i < again.results.size(); ++i)
+        {
+            EXPECT_EQ(again.results[i].id, shards.back().results[i].id);
+        }
+    }
+
+    const auto merged = pep::ResultFile::merge(shards);
+    EXPECT_EQ(merged.exitCode, 0);
+    std::set<std::string> ids;
+    for (const auto& result : merged.results)
+    {
+        EXPECT_EQ(result.status, pep::ScenarioResult::Status::Passed);
+        ids.insert(result.id);
+    }
+    EXPECT_EQ(merged.results.size(), ids.size());
+    EXPECT_EQ(ids, all);
+
+    shards.pop_back();
+    EXPECT_THROW(pep::ResultFile::merge(shards), std::runtime_error);
+    shards.push_back(shards.front());
+    EXPECT_THROW(pep::ResultFile::merge(shards), std::runtime_error);
+
+    pep::RunOptions outOfRange;
+    outOfRange.shardIndex = 3;
+    outOfRange.shardCount = 3;
+    EXPECT_THROW(pep::run(features, outOfRange), std::invalid_argument);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(PepinoTest, featuresOfTheSameNameKeepTheirScenariosApart)
+{
+    // Both files hold "Feature: Login" with "Scenario: Successful login".
+    const auto directory = std::filesystem::temp_directory_path() / "pepino_same_name_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const std::vector<std::string> features{ "tests/data/broken/good.feature", "tests/data/suite/login.feature" };
+
+    std::vector<pep::ResultFile> shards;
+    for (unsigned index : { 0u, 1u })
+    {
+        pep::RunOptions options;
+        options.shardIndex = index;
+        options.shardCount = 2;
+        options.resultFile = (directory / std::to_string(index)).string();
+        ASSERT_EQ(pep::run(features, options), 0);
+        shards.push_back(pep::ResultFile::read(options.resultFile));
+    }
+    const auto merged = pep::ResultFile::merge(shards);
+    std::set<std::string> ids;
+    for (const auto& result : merged.results)
+    {
+        ids.insert(result.id);
+    }
+    EXPECT_EQ(ids.count("tests/data/broken/good.feature/Successful login"), 1u);
+    EXPECT_EQ(ids.count("tests/data/suite/login.feature/Successful login"), 1u);
+    EXPECT_EQ(ids.size(), merged.results.size());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(PepinoTest, problemsOnlyFailTheShardThatWouldRunThem)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "pepino_shard_problem_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::vector<pep::ResultFile> shards;
+    int failing = 0;
+    for (unsigned index : { 0u, 1u, 2u })
+    {
+        pep::RunOptions options;
+        options.shardIndex = index;
+        options.shardCount = 3;
+        options.resultFile = (directory / std::to_string(index)).string();
+        const int ret = pep::run("tests/data/shard_problems.feature", options);
+        shards.push_back(pep::ResultFile::read(options.resultFile));
+        if (ret != 0)
+        {
+            ++failing;
+            EXPECT_EQ(ret, 42);
+            EXPECT_TRUE(shards.back().results.empty());
+            ASSERT_EQ(shards.back().problems.size(), 1u);
+        }
+        else
+        {
+            EXPECT_TRUE(shards.back().problems.empty());
+        }
+    }
+    EXPECT_EQ(failing, 1);
+
+    const auto merged = pep::ResultFile::merge(shards);
+    EXPECT_EQ(merged.exitCode, 42);
+    ASSERT_EQ(merged.problems.size(), 1u);
+    EXPECT_EQ(merged.problems[0].id, "tests/data/shard_problems.feature/Broken");
+    EXPECT_EQ(merged.problems[0].step, "no step looks like this");
+    EXPECT_EQ(merged.problems[0].scenarios, 1u);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(PepinoTest, shardsAreBalancedByRecordedDurations)
+{
+    std::ifstream file("tests/data/parallel.feature");
+    const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const auto flat = flatFor(source);
+
+    // One scenario takes as long as all the others together; the other shard
+    // gets everything else, including the row with no recorded duration.
+    std::unordered_map<std::string, std::chrono::nanoseconds> durations;
+    const auto ids = pep::ExecutionPlan::compile(flat).scenarios();
+    for (size_t i = 0; i + 1 < ids.size(); ++i)
+    {
+        durations[ids[i].id] = std::chrono::milliseconds(i == 3 ? 100 : 10);
+    }
+
+    std::vector<pep::ExecutionPlan> first, second;
+    first.push_back(pep::ExecutionPlan::compile(flat));
+    second.push_back(pep::ExecutionPlan::compile(flat));
+    pep::selectShard(first, { 0, 2 }, durations);
+    pep::selectShard(second, { 1, 2 }, durations);
+
+    ASSERT_EQ(first[0].scenarios().size(), 1u);
+    EXPECT_EQ(first[0].scenarios()[0].id, ids[3].id);
+    EXPECT_EQ(second[0].scenarios().size(), ids.size() - 1);
+}
+
+WHEN("^the worker crashes$", [](pep::DefaultContext&) { std::raise(SIGSEGV); });
+WHEN("^the worker allocates (\\d+) MB$",
+     [](pep::DefaultContext&, size_t megabytes)
+     {
+         std::vector<char> memory(megabytes << 20, 1);
+         EXPECT_EQ(memory.back(), 1);
+     });
+
+TEST_F(PepinoTest, crashedWorkersAreReportedAndReplaced)
+{
+    std::ifstream file("tests/data/crash.feature");
+    const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const auto plan = planFor(source);
+    ASSERT_TRUE(plan.problems().empty());
+
+    // One worker, so the scenario after the crash can only run on its replacement.
+    pep::WorkerLimits limits;
+    limits.memoryBytes = size_t(256) << 20;
+    const auto results =
+        pep::ProcessPoolTestRunner(1, pep::types::ContextLifetime::Scenario, limits).schedule({ &plan });
+    ASSERT_EQ(results.size(), 4u);
+    EXPECT_EQ(results[0].status, pep::ScenarioResult::Status::Passed);
+    EXPECT_EQ(results[1].status, pep::ScenarioResult::Status::Crashed);
+    EXPECT_EQ(results[1].id, "Crashing workers/The crash");
+    EXPECT_NE(results[1].message.find("signal " + std::to_string(SIGSEGV)), std::string::npos) << results[1].message;
+    EXPECT_EQ(results[2].status, pep::ScenarioResult::Status::Passed);
+    // Over the limit the allocation fails inside the worker, which survives.
+    EXPECT_EQ(results[3].status, pep::ScenarioResult::Status::Error);
+
+    std::vector<pep::ExecutionPlan> plans;
+    plans.push_back(planFor(source));
+    EXPECT_EQ(pep::ProcessPoolTestRunner(2).runPlans(plans, nullptr), 2);
+
+    pep::RunOptions options;
+    options.scenarioProcesses = 2;
+    EXPECT_EQ(pep::run("tests/data/parallel.feature", options), 0);
+}
+
+THEN("^the check (passes|fails)$", [](pep::DefaultContext&, std::string_view outcome)
+     { pep::check(outcome == "passes", "the check failed"); });
+THEN("^the step throws$", [](pep::DefaultContext&) { throw std::logic_error("not a test failure"); });
+
+TEST_F(PepinoTest, testFailuresAreToldApartFromErrors)
+{
+    constexpr std::string_view source = "Feature: Checks\n"
+                                        "  Scenario: Passing\n"
+                                        "    Then the check passes\n"
+                                        "  Scenario: Throwing\n"
+                                        "    Then the step throws\n"
+                                        "  Scenario: Failing\n"
+                                        "    Then the check fails\n";
+    const auto plan = planFor(source);
+    const auto expect = [](const std::vector<pep::ScenarioResult>& results)
+    {
+        ASSERT_EQ(results.size(), 3u);
+        EXPECT_EQ(results[0].status, pep::ScenarioResult::Status::Passed);
+        EXPECT_EQ(results[1].status, pep::ScenarioResult::Status::Error);
+        EXPECT_EQ(results[2].status, pep::ScenarioResult::Status::Failed);
+        EXPECT_EQ(results[2].message, "Failing: the check failed");
+        EXPECT_EQ(results[2].exitCode(), 42);
+    };
+    expect(pep::ParallelTestRunner(2).runPlan(plan));
+    expect(pep::ProcessPoolTestRunner(2).schedule({ &plan }));
+
+    // The basic runner stops a feature at its first failing scenario.
+    std::vector<pep::ExecutionPlan> plans;
+    plans.push_back(planFor("Feature: Checks\n  Scenario: Failing\n    Then the check fails\n"));
+    std::vector<pep::ScenarioResult> results;
+    EXPECT_EQ(pep::BasicTestRunner().runPlans(plans, &results), 42);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].status, pep::ScenarioResult::Status::Failed);
+}
+
+WHEN("^the worker burns (\\d+) ms of CPU$",
+     [](pep::DefaultContext&, int milliseconds)
+     {
+         const auto until = std::clock() + static_cast<std::clock_t>(milliseconds) * CLOCKS_PER_SEC / 1000;
+         while (std::clock() < until)
+         {
+         }
+     });
+
+TEST_F(PepinoTest, cpuLimitsApplyToEachScenario)
+{
+    // Together the first three take more than a second; each alone does not.
+    const auto plan = planFor("Feature: CPU limits\n"
+                              "  Scenario: First\n"
+                              "    When the worker burns 400 ms of CPU\n"
+                              "  Scenario: Second\n"
+                              "    When the worker burns 400 ms of CPU\n"
+                              "  Scenario: Third\n"
+                              "    When the worker burns 400 ms of CPU\n"
+                              "  Scenario: Endless\n"
+                              "    When the worker burns 10000 ms of CPU\n");
+    pep::WorkerLimits limits;
+    limits.cpuSeconds = 1;
+    const auto results =
+        pep::ProcessPoolTestRunner(1, pep::types::ContextLifetime::Scenario, limits).schedule({ &plan });
+    ASSERT_EQ(results.size(), 4u);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(results[i].status, pep::ScenarioResult::Status::Passed) << results[i].message;
+    }
+    EXPECT_EQ(results[3].status, pep::ScenarioResult::Status::Crashed);
+    EXPECT_NE(results[3].message.find("signal " + std::to_string(SIGXCPU)), std::string::npos) << results[3].message;
+}
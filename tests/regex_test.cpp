@@ -0,0 +1,215 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+#include "../src/matching/Regex.h"
+#include "../src/matching/StepMatcher.h"
+
+#include <gtest/gtest.h>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pep::matching;
+
+namespace
+{
+// Runs `pattern` on both backends and expects the same verdict and captures.
+void expectSameAsStdRegex(const std::string& pattern, const std::vector<std::string>& texts)
+{
+    const auto builtin = makeBuiltinMatcher(pattern);
+    ASSERT_TRUE(builtin) << "not supported: " << pattern;
+    const auto reference = makeStdRegexMatcher(pattern);
+    EXPECT_EQ(builtin->groups(), reference->groups()) << pattern;
+    for (const auto& text : texts)
+    {
+        CaptureSpans expected;
+        CaptureSpans actual;
+        const bool expectedMatch = reference->match(text, &expected);
+        EXPECT_EQ(builtin->match(text, &actual), expectedMatch) << pattern << " on '" << text << "'";
+        if (expectedMatch)
+        {
+            EXPECT_EQ(actual, expected) << pattern << " on '" << text << "'";
+        }
+    }
+}
+} // namespace
+
+TEST(RegexTest, StepPatternsMatchLikeStdRegex)
+{
+    const std::vector<std::string> texts = {
+        "",
+        "a name bob",
+        "a name 42",
+        "the user enters \"alice\" and \"secret\"",
+        "I have 3 cucumbers in my belly",
+        "I have 12.50 euros",
+        "an apple",
+        "a pear",
+        "I wait 10 seconds",
+        "I wait 1 second",
+        "the list is empty",
+        "the list contains a, b and c",
+        "x\ty",
+        "Ünïcödé text",
+    };
+    const std::vector<std::string> patterns = {
+        "^a name (\\w+)$",
+        "^a name (\\d+)$",
+        "^the user enters \"([^\"]*)\" and \"([^\"]*)\"$",
+        "^I have (\\d+) cucumbers? in my (\\w+)$",
+        "^I have (-?\\d+(?:\\.\\d+)?) (euros|dollars)$",
+        "^an? (apple|pear)$",
+        "^I wait (\\d+) seconds?$",
+        "^the list (is empty|contains (.*))$",
+        "^the list contains (.*?)(?: and (.*))?$",
+        "^(.*) (.*)$",
+        "^(.*?) (.*)$",
+        "^(\\S+)\\s(\\S+)$",
+        "^[^a-z]*(\\w*)\\W*(.*)$",
+        "^(a|ab)(c|bcd)?(.*)$",
+        "^I (?:wait|sleep) (\\d{1,2}) (\\w{3,})$",
+        "I have (\\d+)",
+        ".*",
+        "^$",
+        "(\\w+)\\.(\\w+)|(\\w+)",
+        "^[\\w\\s,]+$",
+        "^(x)?(\\t)?(y)?$",
+        "^([\\x80-\\xff]*|[^a-z ]+) text$",
+    };
+    for (const auto& pattern : patterns)
+    {
+        if (pattern.find("\\x") != std::string::npos)
+        {
+            EXPECT_FALSE(makeBuiltinMatcher(pattern)) << pattern; // \x escapes are left to std::regex
+            continue;
+        }
+        expectSameAsStdRegex(pattern, texts);
+    }
+}
+
+// Random patterns over a tiny alphabet exercise priorities between greedy and
+// lazy quantifiers and alternatives far more than hand-written ones.
+TEST(RegexTest, RandomPatternsMatchLikeStdRegex)
+{
+    std::mt19937 rng(20240611);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+
+    // Quantified groups never capture: ECMAScript resets captures on every
+    // iteration, which neither engine is asked to agree on here. Groups are
+    // not repeated without bound either, or std::regex backtracks for ages.
+    std::function<std::string(int, bool)> generate = [&](int depth, bool allowCapture) -> std::string
+    {
+        std::string out;
+        const size_t atoms = 1 + pick(3);
+        for (size_t i = 0; i < atoms; ++i)
+        {
+            std::string atom;
+            bool capturing = false;
+            bool group = false;
+            switch (depth > 0 ? pick(6) : pick(4))
+            {
+            case 0:
+                atom = "a";
+                break;
+            case 1:
+                atom = "b";
+                break;
+            case 2:
+                atom = ".";
+                break;
+            case 3:
+                atom = "[ab]";
+                break;
+            default:
+                group = true;
+                capturing = allowCapture && pick(2);
+                atom = (capturing ? "(" : "(?:") + generate(depth - 1, capturing) + "|" +
+                       generate(depth - 1, capturing) + ")";
+                break;
+            }
+            if (group && !capturing)
+            {
+                static const char* quantifiers[] = { "", "?", "{1,2}", "??" };
+                atom += quantifiers[pick(std::size(quantifiers))];
+            }
+            else if (!group)
+            {
+                static const char* quantifiers[] = { "", "", "*", "+", "?", "{1,2}", "*?", "+?", "??" };
+                atom += quantifiers[pick(std::size(quantifiers))];
+            }
+            out += atom;
+        }
+        return out;
+    };
+
+    std::vector<std::string> texts;
+    for (size_t length = 0; length <= 6; ++length)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            std::string text;
+            for (size_t c = 0; c < length; ++c)
+                text += "abc"[pick(3)];
+            texts.push_back(text);
+        }
+    }
+
+    for (int i = 0; i < 300; ++i)
+        expectSameAsStdRegex(generate(2, true), texts);
+}
+
+// Large patterns on long texts are run by the Pike VM rather than the
+// backtracker; both must agree with std::regex.
+TEST(RegexTest, LargePatternsMatchLikeStdRegex)
+{
+    std::mt19937 rng(7);
+    std::vector<std::string> texts;
+    for (size_t length : { 150, 220, 300 })
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            std::string text;
+            for (size_t c = 0; c < length; ++c)
+                text += "ab c"[rng() % 4];
+            texts.push_back(text);
+        }
+    }
+    texts.push_back(std::string(250, 'a') + "c");
+    expectSameAsStdRegex("^(?:a|b){0,300}?(\\w*)( ?)(.*?)c?$", texts);
+    expectSameAsStdRegex("^((?:[ab]+ ?){1,200})(c.*)?$", texts);
+}
+
+TEST(RegexTest, UnsupportedSyntaxIsLeftToStdRegex)
+{
+    for (const char* pattern : { "(a)\\1", "(?=a)a", "a\\b", "\\u0041", "[[:alpha:]]", "a**", "(a", "[]" })
+    {
+        EXPECT_FALSE(Regex::compile(pattern)) << pattern;
+    }
+    // makeMatcher still accepts what std::regex accepts.
+    const auto matcher = makeMatcher("(a)\\1", pep::types::RegexBackend::Builtin);
+    EXPECT_TRUE(matcher->match("aa", nullptr));
+}
+
+TEST(RegexTest, MatchingTimeIsLinear)
+{
+    // Exponential for a backtracking engine, a single pass for the Pike VM.
+    const auto regex = Regex::compile("^(?:a|a)*(?:a|a)*b$");
+    ASSERT_TRUE(regex);
+    const std::string text(20000, 'a');
+    EXPECT_FALSE(regex->match(text, nullptr));
+    EXPECT_TRUE(regex->match(text + "b", nullptr));
+}
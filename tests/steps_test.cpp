@@ -14,15 +14,47 @@
  *
  *******************************************************************************/
 
+#include "../src/matching/Automaton.h"
+#include "../src/matching/CucumberExpression.h"
+#include "../src/matching/StepIndex.h"
 #include "pepino/context.h"
 #include "pepino/pepino.h"
 #include "pepino/steps/steps.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <cstdlib>
+#include <new>
+#include <regex>
 
 using namespace testing;
 
+namespace
+{
+// Counts the heap allocations made by this thread while `countAllocations` is set.
+thread_local bool countAllocations = false;
+thread_local size_t allocations = 0;
+} // namespace
+
+void* operator new(size_t size)
+{
+    if (countAllocations)
+        ++allocations;
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
 class PepinoStepsTest : public testing::Test
 {
 };
@@ -31,6 +63,7 @@ class MyContext : public pep::Context<MyContext>
 {
 public:
     std::string name{};
+    std::string_view view{};
     int number{};
     testing::MockFunction<void()> mockCb;
 };
@@ -51,6 +84,264 @@ TEST_F(PepinoStepsTest, typeAssertion)
     EXPECT_EQ(MyContext::getInstance().number, 42);
 }
 
+TEST_F(PepinoStepsTest, resolutionCacheCountsHitsAndMisses)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    registry.clearResolutionCache();
+
+    registry.executeStep("a name against");
+    EXPECT_EQ(registry.cacheStats().misses, 1);
+    EXPECT_EQ(registry.cacheStats().hits, 0);
+    registry.executeStep("a name against");
+    registry.executeStep("a name against");
+    EXPECT_EQ(MyContext::getInstance().name, "against");
+    EXPECT_EQ(registry.cacheStats().hits, 2);
+    EXPECT_EQ(registry.cacheStats().entries, 1);
+
+    // Texts that match nothing are cached as well, and still throw.
+    EXPECT_THROW(registry.executeStep("no step looks like this"), std::runtime_error);
+    EXPECT_THROW(registry.executeStep("no step looks like this"), std::runtime_error);
+    EXPECT_EQ(registry.cacheStats().misses, 2);
+    EXPECT_EQ(registry.cacheStats().hits, 3);
+
+    // Registering a step invalidates everything resolved so far.
+    registry.registerStep<MyContext>(pep::types::StepType::Given,
+                                     "^a cached name (\\w+)$",
+                                     [](MyContext& ctx, std::string name) { ctx.name = name; });
+    EXPECT_EQ(registry.cacheStats().entries, 0);
+    registry.executeStep("a cached name fresh");
+    EXPECT_EQ(MyContext::getInstance().name, "fresh");
+}
+
+TEST_F(PepinoStepsTest, patternsAreSortedIntoTiers)
+{
+    using pep::matching::Tier;
+    using pep::matching::analyzePattern;
+
+    EXPECT_EQ(analyzePattern("^the user logs out$").tier, Tier::Exact);
+    EXPECT_EQ(analyzePattern("^the user logs out$").literal, "the user logs out");
+    EXPECT_EQ(analyzePattern("costs 3\\.50\\$").literal, "costs 3.50$");
+    EXPECT_EQ(analyzePattern("costs 3\\.50\\$").tier, Tier::Exact);
+
+    EXPECT_EQ(analyzePattern("^a name (\\w+)$").tier, Tier::Prefix);
+    EXPECT_EQ(analyzePattern("^a name (\\w+)$").literal, "a name ");
+    // A quantified character is not part of the prefix.
+    EXPECT_EQ(analyzePattern("^an? apple$").literal, "a");
+    EXPECT_EQ(analyzePattern("^items\\d+$").literal, "items");
+
+    EXPECT_EQ(analyzePattern("^(\\d+) apples$").tier, Tier::Regex);
+    EXPECT_EQ(analyzePattern("^login ok|logout ok$").tier, Tier::Regex);
+    EXPECT_EQ(analyzePattern("^log(in|out) ok$").literal, "log");
+}
+
+TEST_F(PepinoStepsTest, stepIndexCollectsOnlyPossibleCandidates)
+{
+    using pep::matching::analyzePattern;
+    pep::matching::StepIndex index;
+    index.add(0, analyzePattern("^a name (\\w+)$"));
+    index.add(1, analyzePattern("^a number (\\d+)$"));
+    index.add(2, analyzePattern("^a name bob$"));
+    index.add(3, analyzePattern("^(\\w+) is here$"));
+
+    std::vector<pep::matching::StepIndex::Candidate> candidates;
+    index.collect("a name bob", candidates);
+    std::vector<std::pair<uint32_t, bool>> found;
+    for (const auto& c : candidates)
+        found.emplace_back(c.id, c.exact);
+    EXPECT_THAT(found, UnorderedElementsAre(Pair(0, false), Pair(2, true), Pair(3, false)));
+
+    candidates.clear();
+    index.collect("bob is here", candidates);
+    ASSERT_EQ(candidates.size(), 1);
+    EXPECT_EQ(candidates[0].id, 3);
+}
+
+TEST_F(PepinoStepsTest, tieredLookupKeepsSpecificityRanking)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    registry.registerStep<MyContext>(pep::types::StepType::Given,
+                                     "^a tiered step (\\w+)$",
+                                     [](MyContext& ctx, std::string name) { ctx.name = "regex " + name; });
+    registry.registerStep<MyContext>(pep::types::StepType::Given,
+                                     "^a tiered step literal$",
+                                     [](MyContext& ctx) { ctx.name = "literal"; });
+    registry.registerStep<MyContext>(pep::types::StepType::Given,
+                                     "^(\\w+) tiered step literal$",
+                                     [](MyContext& ctx, std::string) { ctx.name = "general"; });
+
+    // The literal pattern is the most specific, though registered later.
+    registry.executeStep("a tiered step literal");
+    EXPECT_EQ(MyContext::getInstance().name, "literal");
+    registry.executeStep("a tiered step other");
+    EXPECT_EQ(MyContext::getInstance().name, "regex other");
+    registry.executeStep("the tiered step literal");
+    EXPECT_EQ(MyContext::getInstance().name, "general");
+}
+
+TEST_F(PepinoStepsTest, automatonAgreesWithStdRegex)
+{
+    const std::vector<std::string> patterns = {
+        "^a name (\\w+)$",        "^a name (\\d+)$",       "^an? (apple|pear)s?$", "^(\\d{2,3}) items?$",
+        "^[A-Z][a-z]* logs in$",  "^.* logs in$",          "costs \\$\\d+\\.\\d\\d", "^(?:ab)+c?$",
+        "^x{0,2}y*?$",            "^[^ ]+ \\s*\\S+$",       "^$",                   "^a\\b",
+    };
+    const std::vector<std::string> texts = {
+        "a name bob", "a name 42", "an apple",  "a pears", "12 items", "1234 item", "Alice logs in",
+        "alice logs in", "costs $12.50", "ababc", "abc", "xxy", "xxxy", "", "a  b", "ab b",
+    };
+
+    pep::matching::Automaton automaton;
+    std::vector<bool> supported;
+    for (size_t i = 0; i < patterns.size(); ++i)
+        supported.push_back(automaton.add(static_cast<uint32_t>(i), patterns[i]));
+    EXPECT_FALSE(supported.back()); // \b is left to std::regex
+    EXPECT_EQ(automaton.patternCount(), patterns.size() - 1);
+
+    for (int pass = 0; pass < 2; ++pass) // The second pass runs on cached states
+    {
+        for (const auto& text : texts)
+        {
+            std::vector<uint32_t> expected;
+            for (size_t i = 0; i < patterns.size(); ++i)
+            {
+                if (supported[i] && std::regex_match(text, std::regex(patterns[i])))
+                    expected.push_back(static_cast<uint32_t>(i));
+            }
+            std::vector<uint32_t> found;
+            automaton.matchAll(text, found);
+            std::sort(found.begin(), found.end());
+            EXPECT_EQ(found, expected) << "text: '" << text << "'";
+        }
+    }
+}
+
+TEST_F(PepinoStepsTest, matchStrategiesPickTheSameStep)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    registry.registerStep<MyContext>(pep::types::StepType::Given,
+                                     "^a strategy step (\\w+)$",
+                                     [](MyContext& ctx, std::string name) { ctx.name = "word " + name; });
+    registry.registerStep<MyContext>(pep::types::StepType::Given,
+                                     "^a strategy step (\\d+)$",
+                                     [](MyContext& ctx, int n) { ctx.name = "number " + std::to_string(n); });
+    registry.registerStep<MyContext>(pep::types::StepType::Given,
+                                     "^a strategy step (.*) y\\b$",
+                                     [](MyContext& ctx, std::string rest) { ctx.name = "rest " + rest; });
+
+    const std::vector<std::string> texts = { "a strategy step bob", "a strategy step 7", "a strategy step x y" };
+    std::vector<std::string> expected;
+    for (auto strategy :
+         { pep::types::MatchStrategy::Linear, pep::types::MatchStrategy::Tiered, pep::types::MatchStrategy::Automaton })
+    {
+        registry.setMatchStrategy(strategy);
+        EXPECT_EQ(registry.matchStrategy(), strategy);
+        std::vector<std::string> names;
+        for (const auto& text : texts)
+        {
+            registry.executeStep(text);
+            names.push_back(MyContext::getInstance().name);
+        }
+        if (expected.empty())
+            expected = names;
+        EXPECT_EQ(names, expected);
+    }
+    EXPECT_EQ(expected, (std::vector<std::string>{ "word bob", "number 7", "rest x" }));
+    registry.setMatchStrategy(pep::types::MatchStrategy::Tiered);
+}
+
+TEST_F(PepinoStepsTest, compileTimePatternsMatchLikeRuntimeOnes)
+{
+    static_assert(pep::StaticPattern<"^a compiled step (\\d+) for (\\w+)$">::groups == 2);
+    static_assert(pep::StaticPattern<"^no captures (?:here|there)$">::groups == 0);
+
+    auto& registry = pep::StepRegistry::getInstance();
+    registry.executeStep("a compiled step 12 for carol");
+    EXPECT_EQ(MyContext::getInstance().number, 12);
+    EXPECT_EQ(MyContext::getInstance().name, "carol");
+
+    // Build-time programs are kept when the backend changes.
+    registry.setRegexBackend(pep::types::RegexBackend::StdRegex);
+    registry.executeStep("a compiled step 13 for dave");
+    EXPECT_EQ(MyContext::getInstance().name, "dave");
+    registry.setRegexBackend(pep::types::RegexBackend::Builtin);
+}
+
+CT_GIVEN_CTX(MyContext,
+             "^a compiled step (\\d+) for (\\w+)$",
+             [](MyContext& ctx, int number, std::string name)
+             {
+                 ctx.number = number;
+                 ctx.name = name;
+             });
+
+TEST_F(PepinoStepsTest, cucumberExpressionsAreDetected)
+{
+    using pep::matching::isCucumberExpression;
+    EXPECT_TRUE(isCucumberExpression("a number {int}"));
+    EXPECT_TRUE(isCucumberExpression("{word} logs in"));
+    EXPECT_TRUE(isCucumberExpression("anything {}"));
+    EXPECT_FALSE(isCucumberExpression("^a number {int}$"));
+    EXPECT_FALSE(isCucumberExpression("^a number (\\d+)$"));
+    EXPECT_FALSE(isCucumberExpression("a{2} b"));
+    EXPECT_FALSE(isCucumberExpression("plain text"));
+}
+
+TEST_F(PepinoStepsTest, cucumberExpressionsScanTypedSlots)
+{
+    using pep::matching::CaptureSpans;
+    auto captured = [](std::string_view expression, std::string_view text) -> std::vector<std::string>
+    {
+        CaptureSpans spans;
+        if (!pep::matching::makeExpressionMatcher(expression)->match(text, &spans))
+            return { "<no match>" };
+        std::vector<std::string> values;
+        for (auto [offset, length] : spans)
+            values.emplace_back(text.substr(offset, length));
+        return values;
+    };
+
+    EXPECT_THAT(captured("I have {int} cucumber(s) in my {word}", "I have 42 cucumbers in my belly"),
+                ElementsAre("42", "belly"));
+    EXPECT_THAT(captured("I have {int} cucumber(s) in my {word}", "I have -1 cucumber in my belly"),
+                ElementsAre("-1", "belly"));
+    EXPECT_THAT(captured("I have {int} cucumber(s) in my {word}", "I have 4.5 cucumbers in my belly"),
+                ElementsAre("<no match>"));
+    EXPECT_THAT(captured("user {string} logs in with {string}", "user \"alice b\" logs in with 'pa\\'ss'"),
+                ElementsAre("alice b", "pa\\'ss"));
+    EXPECT_THAT(captured("it costs {float} euros", "it costs 12.50 euros"), ElementsAre("12.50"));
+    EXPECT_THAT(captured("it costs {float} euros", "it costs .5 euros"), ElementsAre(".5"));
+    EXPECT_THAT(captured("it costs {float} euros", "it costs 1e3 euros"), ElementsAre("1e3"));
+    EXPECT_THAT(captured("I eat/drink {int} thing(s)", "I drink 3 things"), ElementsAre("3"));
+    EXPECT_THAT(captured("I eat/drink {int} thing(s)", "I sleep 3 things"), ElementsAre("<no match>"));
+    EXPECT_THAT(captured("the rest is {}", "the rest is whatever you like"), ElementsAre("whatever you like"));
+    EXPECT_THAT(captured("{} and {}", "a and b and c"), ElementsAre("a and b", "c"));
+    EXPECT_THAT(captured("a \\{int\\} literal", "a {int} literal"), ElementsAre());
+
+    EXPECT_THROW(pep::matching::makeExpressionMatcher("a {int"), std::invalid_argument);
+    EXPECT_THROW(pep::matching::makeExpressionMatcher("a {nosuchtype}")->match("a b", nullptr),
+                 std::invalid_argument);
+}
+
+TEST_F(PepinoStepsTest, cucumberExpressionStepsRunWithTypedArguments)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    registry.executeStep("the basket holds 7 red apples");
+    EXPECT_EQ(MyContext::getInstance().number, 7);
+    EXPECT_EQ(MyContext::getInstance().name, "red");
+    EXPECT_THROW(registry.executeStep("the basket holds 7 purple apples"), std::runtime_error);
+}
+
+PARAMETER_TYPE("color",
+               [](std::string_view text) { return text == "red" || text == "green" || text == "blue"; });
+
+GIVEN_CTX(MyContext,
+          "the basket holds {int} {color} apple(s)",
+          [](MyContext& ctx, int count, std::string color)
+          {
+              ctx.number = count;
+              ctx.name = color;
+          });
+
 GIVEN_CTX(
     MyContext,
     "^a number (\\d+)$",
@@ -77,3 +368,174 @@ GIVEN_CTX(
         std::cout << "Received name w/ number: " << name << std::endl;
         ctx.number = name;
     });
+
+TEST_F(PepinoStepsTest, viewAndNumericArgumentsDoNotAllocate)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    auto& ctx = MyContext::getInstance();
+    const std::string stepText = "a viewed word rabbit and 17";
+
+    registry.executeStep(stepText); // Resolves once and caches it
+    EXPECT_EQ(ctx.view, "rabbit");
+    EXPECT_EQ(ctx.view.data(), stepText.data() + 14); // A view into the step text, not a copy
+    EXPECT_EQ(ctx.number, 17);
+
+    allocations = 0;
+    countAllocations = true;
+    registry.executeStep(stepText);
+    countAllocations = false;
+    EXPECT_EQ(allocations, 0u);
+}
+
+TEST_F(PepinoStepsTest, capturesBeyondTheInlineOnesArePassedOn)
+{
+    pep::StepRegistry::getInstance().executeStep("nine letters a b c d e f g h i");
+    EXPECT_EQ(MyContext::getInstance().name, "abcdefghi");
+}
+
+GIVEN_CTX(MyContext,
+          "^a viewed word (\\w+) and (\\d+)$",
+          [](MyContext& ctx, std::string_view word, int number)
+          {
+              ctx.view = word;
+              ctx.number = number;
+          });
+
+GIVEN_CTX(MyContext,
+          "^nine letters (\\w) (\\w) (\\w) (\\w) (\\w) (\\w) (\\w) (\\w) (\\w)$",
+          [](MyContext& ctx,
+             std::string_view a,
+             std::string_view b,
+             std::string_view c,
+             std::string_view d,
+             std::string_view e,
+             std::string_view f,
+             std::string_view g,
+             std::string_view h,
+             std::string_view i)
+          { ctx.name.assign(a).append(b).append(c).append(d).append(e).append(f).append(g).append(h).append(i); });
+
+enum class Level
+{
+    Low,
+    High
+};
+
+enum class Unnamed
+{
+    First,
+    Second
+};
+
+ENUM_NAMES(Level, { "low", Level::Low }, { "high", Level::High })
+PARAMETER_TYPE_OF("level", Level)
+
+TEST_F(PepinoStepsTest, convertersParseBuiltInTypes)
+{
+    using namespace std::chrono_literals;
+
+    EXPECT_EQ(pep::tryConvert<int8_t>("-128"), int8_t(-128));
+    EXPECT_EQ(pep::tryConvert<int8_t>("128"), std::nullopt);
+    EXPECT_EQ(pep::tryConvert<uint64_t>("18446744073709551615"), UINT64_MAX);
+    EXPECT_EQ(pep::tryConvert<unsigned>("-1"), std::nullopt);
+    EXPECT_EQ(pep::tryConvert<long>("+42"), 42L);
+    EXPECT_EQ(pep::tryConvert<int>("42abc"), std::nullopt);
+    EXPECT_EQ(pep::tryConvert<int>(""), std::nullopt);
+    EXPECT_EQ(pep::tryConvert<float>("2.5"), 2.5f);
+    EXPECT_EQ(pep::tryConvert<double>("-1e3"), -1000.0);
+    EXPECT_EQ(pep::tryConvert<double>("1.5.2"), std::nullopt);
+    EXPECT_EQ(pep::tryConvert<bool>("yes"), true);
+    EXPECT_EQ(pep::tryConvert<bool>("false"), false);
+    EXPECT_EQ(pep::tryConvert<bool>("maybe"), std::nullopt);
+
+    EXPECT_EQ(pep::tryConvert<std::chrono::milliseconds>("250ms"), 250ms);
+    EXPECT_EQ(pep::tryConvert<std::chrono::milliseconds>("2 s"), 2000ms);
+    EXPECT_EQ(pep::tryConvert<std::chrono::milliseconds>("3"), 3ms);
+    EXPECT_EQ(pep::tryConvert<std::chrono::milliseconds>("1500us"), std::nullopt); // Not a whole millisecond
+    EXPECT_EQ(pep::tryConvert<std::chrono::duration<double>>("1.5min"), std::chrono::duration<double>(90));
+    EXPECT_EQ(pep::tryConvert<std::chrono::seconds>("5 weeks"), std::nullopt);
+
+    EXPECT_EQ(pep::tryConvert<Level>("high"), Level::High);
+    EXPECT_EQ(pep::tryConvert<Level>("1"), std::nullopt);
+    EXPECT_EQ(pep::tryConvert<Unnamed>("1"), Unnamed::Second);
+}
+
+TEST_F(PepinoStepsTest, badArgumentsRaiseStepArgumentErrors)
+{
+    try
+    {
+        pep::StepRegistry::getInstance().executeStep("an alarm at high after soon");
+        FAIL() << "expected a StepArgumentException";
+    }
+    catch (const pep::StepArgumentException& e)
+    {
+        EXPECT_EQ(e.argument(), 1u);
+        EXPECT_EQ(e.type(), "duration");
+        EXPECT_EQ(e.text(), "soon");
+        EXPECT_EQ(e.step(), "an alarm at high after soon");
+        EXPECT_THAT(e.what(), HasSubstr("argument 2"));
+    }
+}
+
+TEST_F(PepinoStepsTest, typedParameterTypesConvertToTheirType)
+{
+    auto& registry = pep::StepRegistry::getInstance();
+    registry.executeStep("an alarm at high after 3s");
+    EXPECT_EQ(MyContext::getInstance().number, 3000 + static_cast<int>(Level::High));
+
+    // "medium" is no {level}, so the expression step does not match at all.
+    EXPECT_THROW(registry.executeStep("the alarm is medium"), std::runtime_error);
+    registry.executeStep("the alarm is low");
+    EXPECT_EQ(MyContext::getInstance().number, static_cast<int>(Level::Low));
+}
+
+GIVEN_CTX(MyContext,
+          "^an alarm at (\\w+) after (.+)$",
+          [](MyContext& ctx, Level level, std::chrono::milliseconds delay)
+          { ctx.number = static_cast<int>(delay.count()) + static_cast<int>(level); });
+
+GIVEN_CTX(MyContext,
+          "the alarm is {level}",
+          [](MyContext& ctx, Level level) { ctx.number = static_cast<int>(level); });
+
+TEST_F(PepinoStepsTest, strictKeywordsOnlySearchTheStepsPartition)
+{
+    using pep::types::StepType;
+    auto& registry = pep::StepRegistry::getInstance();
+    auto& ctx = MyContext::getInstance();
+    registry.registerStep<MyContext>(StepType::Given,
+                                     "^a keyword step (\\w+)$",
+                                     [](MyContext& ctx, std::string word) { ctx.name = "given " + word; });
+    registry.registerStep<MyContext>(StepType::Then,
+                                     "^a keyword step (\\w+)$",
+                                     [](MyContext& ctx, std::string word) { ctx.name = "then " + word; });
+    registry.registerStep<MyContext>(StepType::And,
+                                     "^a step for any keyword$",
+                                     [](MyContext& ctx) { ctx.name = "any"; });
+
+    for (auto strategy : { pep::types::MatchStrategy::Linear,
+                           pep::types::MatchStrategy::Tiered,
+                           pep::types::MatchStrategy::Automaton })
+    {
+        registry.setMatchStrategy(strategy);
+
+        // Without strict mode every keyword sees every definition, and the
+        // earlier registration wins the tie.
+        registry.setStrictKeywords(false);
+        registry.executeStep(StepType::Then, "a keyword step x");
+        EXPECT_EQ(ctx.name, "given x");
+        registry.executeStep(StepType::When, "a keyword step x");
+        EXPECT_EQ(ctx.name, "given x");
+
+        registry.setStrictKeywords(true);
+        registry.executeStep(StepType::Then, "a keyword step x");
+        EXPECT_EQ(ctx.name, "then x");
+        registry.executeStep(StepType::Given, "a keyword step y");
+        EXPECT_EQ(ctx.name, "given y");
+        EXPECT_THROW(registry.executeStep(StepType::When, "a keyword step x"), std::runtime_error);
+        registry.executeStep(StepType::When, "a step for any keyword");
+        EXPECT_EQ(ctx.name, "any");
+    }
+    registry.setStrictKeywords(false);
+    registry.setMatchStrategy(pep::types::MatchStrategy::Tiered);
+}
@@ -0,0 +1,108 @@
+/******************************************************************************
+ * Project:  Pepino
+ * Brief:    A C++ Cucumber interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ *******************************************************************************/
+
+// Combines the result files written by the shards of one run, as with
+// RunOptions::resultFile, into one report and one exit code: that of the
+// first failing shard, or 0 if every scenario passed.
+//
+// Usage: PepinoMergeResults [-o merged-file] shard-file...
+
+#include "../src/ResultFile.h"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (inputs.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [-o merged-file] shard-file..." << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::vector<pep::ResultFile> shards;
+        for (const auto& input : inputs)
+        {
+            shards.push_back(pep::ResultFile::read(input));
+        }
+        const pep::ResultFile merged = pep::ResultFile::merge(shards);
+
+        size_t passed = 0, failed = 0, errors = 0, crashed = 0;
+        for (const auto& result : merged.results)
+        {
+            switch (result.status)
+            {
+            case pep::ScenarioResult::Status::Passed:
+                ++passed;
+                continue;
+            case pep::ScenarioResult::Status::Failed:
+                ++failed;
+                std::cout << "FAILED " << result.id << ": " << result.message << std::endl;
+                break;
+            case pep::ScenarioResult::Status::Crashed:
+                ++crashed;
+                std::cout << "CRASH  " << result.id << ": " << result.message << std::endl;
+                break;
+            default:
+                ++errors;
+                std::cout << "ERROR  " << result.id << ": " << result.message << std::endl;
+                break;
+            }
+        }
+        // Shards with problems ran nothing; say why.
+        for (const auto& problem : merged.problems)
+        {
+            std::cout << "CANNOT RUN " << problem.id;
+            if (problem.scenarios > 1)
+                std::cout << " and " << problem.scenarios - 1 << " more";
+            std::cout << ": " << problem.message << (problem.step.empty() ? "" : ": " + problem.step) << std::endl;
+        }
+        std::cout << merged.results.size() << " scenarios: " << passed << " passed, " << failed << " failed, "
+                  << errors << " errors, " << crashed << " crashed across " << shards.size() << " shards";
+        if (!merged.problems.empty())
+            std::cout << "; " << merged.problems.size() << " problem(s) kept scenarios from running";
+        std::cout << std::endl;
+
+        if (!output.empty())
+        {
+            merged.write(output);
+        }
+        return merged.exitCode;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}